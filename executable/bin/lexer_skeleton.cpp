@@ -1,68 +1,523 @@
 #include "lexer_skeleton.hh"
 
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <stdexcept>
+#include <thread>
+#include <algorithm>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <fstream>
+#include <sstream>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace lexer
 {
-    token_t::token_t(index_t line, index_t start_col, index_t end_col, token_type type, const std::string& val)
-        : _M_line(line), _M_start_col(start_col), _M_end_col(end_col), _M_type(type), _M_val(val)
+    //Returns the index of the lowest set bit of a non-zero mask. Used by 
+    //the vectorized loops that skip runs of characters.
+    static inline int lowest_set_bit(unsigned mask)
+    {
+    #if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<int>(index);
+    #else
+        return __builtin_ctz(mask);
+    #endif
+    }
+
+#ifdef LEXER_PROFILE
+    std::vector<uint64_t> lexer::_M_state_hits;
+    std::vector<uint64_t> lexer::_M_transition_hits;
+
+    void lexer::write_profile(std::ostream& os)
+    {
+        os << "states " << _M_state_hits.size() << "\n";
+        for(size_t state = 0; state < _M_state_hits.size(); ++state)
+        {
+            os << "s " << state << " " << _M_state_hits[state] << "\n";
+            for(int c = 0; c < 256; ++c)
+            {
+                if (_M_transition_hits[state * 256 + c] != 0)
+                    os << "t " << state << " " << c << " " << _M_transition_hits[state * 256 + c] << "\n";
+            }
+        }
+    }
+#endif
+
+    token_t::token_t(index_t offset, index_t length, token_type type)
+        : _M_offset(offset), _M_length(length), _M_type(type)
     {
 
     }
 
     lexer::lexer(const std::string& text)
-        : _M_pos(0), _M_line(0), _M_col(0), _M_text(text)
+        : _M_pos(0), _M_start(0), _M_data(nullptr), _M_length(0), _M_text(text), 
+          _M_buffer_offset(0), _M_source(), _M_buffer_size(0), _M_mapping(nullptr), _M_mapping_length(0), 
+          _M_newlines(), _M_indexed(0)
+    {
+        _M_data = _M_text.data();
+        _M_length = _M_text.length();
+    }
+
+    lexer::lexer(const read_callback_t& source, size_t buffer_size)
+        : _M_pos(0), _M_start(0), _M_data(nullptr), _M_length(0), _M_text(), 
+          _M_buffer_offset(0), _M_source(source), _M_buffer_size(buffer_size == 0 ? 1 : buffer_size), 
+          _M_mapping(nullptr), _M_mapping_length(0), _M_newlines(), _M_indexed(0)
+    {
+        _M_data = _M_text.data();
+    }
+
+    lexer::lexer(std::istream& in, size_t buffer_size)
+        : lexer([&in](char* buffer, size_t size) -> size_t
+            {
+                in.read(buffer, size);
+                return static_cast<size_t>(in.gcount());
+            }, buffer_size)
     {
 
     }
 
+#if defined(__unix__) || defined(__APPLE__)
+    lexer::lexer(int fd, size_t buffer_size)
+        : lexer([fd](char* buffer, size_t size) -> size_t
+            {
+                while(true)
+                {
+                    ssize_t n = ::read(fd, buffer, size);
+                    if (n >= 0)
+                        return static_cast<size_t>(n);
+                    if (errno != EINTR)
+                        return 0;
+                }
+            }, buffer_size)
+    {
+
+    }
+#endif
+
+    lexer::lexer(const char* data, index_t length, index_t pos)
+        : _M_pos(pos), _M_start(pos), _M_data(data), _M_length(length), _M_text(), 
+          _M_buffer_offset(0), _M_source(), _M_buffer_size(0), _M_mapping(nullptr), _M_mapping_length(0), 
+          _M_newlines(), _M_indexed(0)
+    {
+
+    }
+
+    lexer::lexer(lexer&& other)
+        : _M_pos(other._M_pos), _M_start(other._M_start), _M_data(other._M_data), _M_length(other._M_length), _M_text(std::move(other._M_text)), 
+          _M_buffer_offset(other._M_buffer_offset), _M_source(std::move(other._M_source)), 
+          _M_buffer_size(other._M_buffer_size), _M_mapping(other._M_mapping), _M_mapping_length(other._M_mapping_length), 
+          _M_newlines(std::move(other._M_newlines)), _M_indexed(other._M_indexed)
+    {
+        if (!_M_mapping)
+            _M_data = _M_text.data();
+        other._M_mapping = nullptr;
+        other._M_mapping_length = 0;
+        other._M_data = other._M_text.data();
+        other._M_length = 0;
+    }
+
+    lexer::~lexer()
+    {
+    #if defined(__unix__) || defined(__APPLE__)
+        if (_M_mapping)
+            ::munmap(_M_mapping, _M_mapping_length);
+    #endif
+    }
+
+    lexer lexer::from_file(const std::string& path)
+    {
+        lexer l((std::string()));
+    #if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), path);
+        }
+        //An empty file cannot be mapped
+        if (st.st_size > 0)
+        {
+            //Reserve one byte more than the file in zeroed anonymous pages and map the 
+            //file over their start, so the input is followed by a NUL sentinel even when 
+            //the file ends on a page boundary
+            size_t size = static_cast<size_t>(st.st_size);
+            void* reserved = ::mmap(nullptr, size + 1, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            void* mapping = MAP_FAILED;
+            if (reserved != MAP_FAILED)
+                mapping = ::mmap(reserved, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+            int error = errno;
+            ::close(fd);
+            if (mapping == MAP_FAILED)
+            {
+                if (reserved != MAP_FAILED)
+                    ::munmap(reserved, size + 1);
+                throw std::system_error(error, std::generic_category(), path);
+            }
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+            l._M_mapping = mapping;
+            l._M_mapping_length = size + 1;
+            l._M_data = static_cast<const char*>(mapping);
+            l._M_length = size;
+        }
+        else
+        {
+            ::close(fd);
+        }
+    #else
+        std::ifstream fin(path.c_str(), std::ios::binary);
+        if (!fin.is_open())
+            throw std::system_error(ENOENT, std::generic_category(), path);
+        std::ostringstream contents;
+        contents << fin.rdbuf();
+        l._M_text = contents.str();
+        l._M_data = l._M_text.data();
+        l._M_length = l._M_text.length();
+    #endif
+        return l;
+    }
+
     std::vector<token_t> lexer::tokenize()
     {
         std::vector<token_t> tokens;
         token_t tok;
-        do
+        while(true)
         {
             tok = next_token();
+            if (tok._M_type == token_type::tl_EOF)
+                break;
             tokens.push_back(tok);
-        } while(_M_pos < _M_text.length());
-        tokens.push_back(make_token(token_type::tl_EOF,"$"));
+        }
+        _M_start = _M_pos;
+        tokens.push_back(make_token(token_type::tl_EOF));
         return tokens;
     }
 
-    token_t lexer::next_token() {
+    void lexer::lex_chunk(index_t begin, index_t end, chunk_t& chunk) const
+    {
+        lexer l(_M_data, _M_length, begin);
+        while(true)
+        {
+            token_t tok = l.next_token();
+            if (tok._M_type == token_type::tl_EOF || tok._M_offset >= end)
+            {
+                chunk._M_stop = tok;
+                return;
+            }
+            chunk._M_tokens.push_back(tok);
+        }
+    }
+
+    std::vector<token_t> lexer::tokenize_parallel(size_t threads, index_t min_chunk)
+    {
+        if (_M_source || _M_pos != 0)
+            return tokenize();
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        //Split after a run of whitespace. A token never continues past whitespace, so 
+        //the sequential lexer almost always starts a token at each split point.
+        std::vector<index_t> splits(1, 0);
+        index_t chunk_size = std::max(min_chunk, _M_length / threads);
+        index_t target = chunk_size;
+        while(target < _M_length && splits.size() < threads)
+        {
+            index_t p = target;
+            while(p < _M_length && !isspace(static_cast<unsigned char>(_M_data[p])))
+                ++p;
+            while(p < _M_length && isspace(static_cast<unsigned char>(_M_data[p])))
+                ++p;
+            if (p >= _M_length)
+                break;
+            splits.push_back(p);
+            target = p + chunk_size;
+        }
+        if (splits.size() == 1)
+            return tokenize();
+        splits.push_back(_M_length);
+
+        std::vector<chunk_t> chunks(splits.size() - 1);
+        std::vector<std::thread> workers;
+        for(size_t i = 1; i < chunks.size(); ++i)
+            workers.push_back(std::thread(&lexer::lex_chunk, this, splits[i], splits[i + 1], std::ref(chunks[i])));
+        lex_chunk(0, splits[1], chunks[0]);
+        for(auto& worker: workers)
+            worker.join();
 
+        //Stitch the chunks together. stop is the first token of the sequential result 
+        //that has not been added yet; it starts at or after the current chunk.
+        std::vector<token_t> tokens;
+        tokens.swap(chunks[0]._M_tokens);
+        token_t stop = chunks[0]._M_stop;
+        for(size_t i = 1; i < chunks.size() && stop._M_type != token_type::tl_EOF; ++i)
+        {
+            const auto& speculative = chunks[i]._M_tokens;
+            auto it = speculative.begin();
+            //Re-lex from the true position until a token starts where a speculative 
+            //token starts; from there on the chunk's tokens are correct. This is 
+            //usually the very first token.
+            lexer l(_M_data, _M_length, stop._M_offset);
+            while(true)
+            {
+                token_t tok = l.next_token();
+                if (tok._M_type == token_type::tl_EOF || tok._M_offset >= splits[i + 1])
+                {
+                    stop = tok;
+                    break;
+                }
+                while(it != speculative.end() && it->_M_offset < tok._M_offset)
+                    ++it;
+                if (it != speculative.end() && it->_M_offset == tok._M_offset)
+                {
+                    tokens.insert(tokens.end(), it, speculative.end());
+                    stop = chunks[i]._M_stop;
+                    break;
+                }
+                tokens.push_back(tok);
+            }
+        }
+        tokens.push_back(stop);
+        _M_pos = _M_start = _M_length;
+        return tokens;
     }
 
-    void lexer::advance()
+    splice_t lexer::relex(std::vector<token_t>& tokens, index_t offset, index_t deleted, const std::string& inserted)
     {
-        if (_M_pos >= _M_text.length())
-            return;
-        do 
+        if (_M_source || _M_buffer_offset != 0)
+            throw std::logic_error("streamed input cannot be edited");
+        if (offset > _M_length || deleted > _M_length - offset)
+            throw std::out_of_range("edit is outside of the input");
+    #if defined(__unix__) || defined(__APPLE__)
+        if (_M_mapping)
         {
-            ++_M_pos;
-            if (_M_text[_M_pos] == '\n')
+            _M_text.assign(_M_data, _M_length);
+            ::munmap(_M_mapping, _M_mapping_length);
+            _M_mapping = nullptr;
+            _M_mapping_length = 0;
+        }
+    #endif
+        _M_text.replace(offset, deleted, inserted);
+        _M_data = _M_text.data();
+        _M_length = _M_text.length();
+        //Forget the newlines from the edit on
+        _M_newlines.erase(std::lower_bound(_M_newlines.begin(), _M_newlines.end(), offset), _M_newlines.end());
+        _M_indexed = std::min(_M_indexed, offset);
+
+        //A token depends on its characters and the character after it that ended it, 
+        //so the tokens that end before the edit are unchanged
+        size_t first = std::partition_point(tokens.begin(), tokens.end(), [offset](const token_t& t)
+            {
+                return t._M_offset + t._M_length < offset;
+            }) - tokens.begin();
+        index_t old_edit_end = offset + deleted;
+        index_t new_edit_end = offset + inserted.length();
+        _M_pos = (first == 0) ? 0 : tokens[first - 1]._M_offset + tokens[first - 1]._M_length;
+        //Lex until a token starts after the edit at the same place as an old token; 
+        //from there on the text and therefore the tokens are the same as before
+        std::vector<token_t> fresh;
+        size_t last = first;
+        while(true)
+        {
+            token_t tok = next_token();
+            if (tok._M_offset >= new_edit_end)
             {
-                ++_M_line; 
-                _M_col = 0;
+                while(last < tokens.size() && (tokens[last]._M_offset < old_edit_end || 
+                        tokens[last]._M_offset - deleted + inserted.length() < tok._M_offset))
+                    ++last;
+                if (last < tokens.size() && tokens[last]._M_offset - deleted + inserted.length() == tok._M_offset)
+                    break;
             }
-            else 
+            fresh.push_back(tok);
+            if (tok._M_type == token_type::tl_EOF)
             {
-                ++_M_col;
+                last = tokens.size();
+                break;
             }
-        } while(isspace(_M_text[_M_pos]));
+        }
+        _M_pos = _M_start = _M_length;
+
+        for(size_t i = last; i < tokens.size(); ++i)
+            tokens[i]._M_offset = tokens[i]._M_offset - deleted + inserted.length();
+        splice_t splice;
+        splice._M_first = first;
+        splice._M_removed = last - first;
+        splice._M_inserted = fresh.size();
+        //Overwrite the tokens both vectors have room for and insert or erase the rest
+        size_t common = std::min(splice._M_removed, splice._M_inserted);
+        std::copy(fresh.begin(), fresh.begin() + common, tokens.begin() + first);
+        if (splice._M_inserted > common)
+            tokens.insert(tokens.begin() + first + common, fresh.begin() + common, fresh.end());
+        else
+            tokens.erase(tokens.begin() + first + common, tokens.begin() + last);
+        return splice;
+    }
+
+    size_t lexer::next_tokens(uint16_t* types, uint32_t* offsets, uint32_t* lengths, size_t capacity, index_t& base)
+    {
+        //Leave room for one more token after the limit so relative offsets fit in 32 bits
+        const index_t MAX_SPAN = index_t(1) << 31;
+        size_t count = 0;
+        while(count < capacity)
+        {
+            if (count > 0 && _M_buffer_offset + _M_pos - base >= MAX_SPAN)
+                break;
+            token_t tok = next_token();
+            if (tok._M_type == token_type::tl_EOF)
+                break;
+            if (count == 0)
+                base = tok._M_offset;
+            types[count] = static_cast<uint16_t>(tok._M_type);
+            offsets[count] = static_cast<uint32_t>(tok._M_offset - base);
+            lengths[count] = static_cast<uint32_t>(tok._M_length);
+            ++count;
+        }
+        return count;
+    }
+
+    const char* lexer::data(const token_t& t) const
+    {
+        return _M_data + (t._M_offset - _M_buffer_offset);
+    }
+
+    std::string lexer::text(const token_t& t) const
+    {
+        return std::string(data(t), t._M_length);
+    }
+
+    position_t lexer::position(index_t offset) const
+    {
+        if (offset > _M_indexed)
+            index_newlines(std::min(offset, _M_buffer_offset + _M_length));
+        index_t line = std::lower_bound(_M_newlines.begin(), _M_newlines.end(), offset) - _M_newlines.begin();
+        index_t line_start = (line == 0) ? 0 : _M_newlines[line - 1] + 1;
+        position_t pos;
+        pos._M_line = line;
+        pos._M_col = offset - line_start;
+        return pos;
+    }
+
+    void lexer::index_newlines(index_t end) const
+    {
+        const char* p = _M_data + (_M_indexed - _M_buffer_offset);
+        const char* last = _M_data + (end - _M_buffer_offset);
+    #if defined(__AVX2__)
+        const __m256i newline = _mm256_set1_epi8('\n');
+        for(; last - p >= 32; p += 32)
+        {
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), newline)));
+            for(; mask; mask &= mask - 1)
+                _M_newlines.push_back(_M_buffer_offset + (p - _M_data) + lowest_set_bit(mask));
+        }
+    #elif defined(__SSE2__)
+        const __m128i newline = _mm_set1_epi8('\n');
+        for(; last - p >= 16; p += 16)
+        {
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), newline)));
+            for(; mask; mask &= mask - 1)
+                _M_newlines.push_back(_M_buffer_offset + (p - _M_data) + lowest_set_bit(mask));
+        }
+    #endif
+        for(; p < last; ++p)
+        {
+            if (*p == '\n')
+                _M_newlines.push_back(_M_buffer_offset + (p - _M_data));
+        }
+        _M_indexed = end;
+    }
+
+    token_t lexer::next_token() {
+
+    }
+
+    void lexer::advance()
+    {
+        ++_M_pos;
     }
 
-    char lexer::next_character() const
+    char lexer::next_character()
     {
-        return (_M_pos >= _M_text.length()) ? 0 : _M_text[_M_pos];
+        char c = _M_data[_M_pos];
+        //Only a NUL can be the sentinel after the end of the buffer
+        if (c == 0 && _M_pos >= _M_length && refill())
+            c = _M_data[_M_pos];
+        return c;
     }
 
-    char lexer::lookahead() const 
+    char lexer::lookahead()
     {
-        return (_M_pos + 1 >= _M_text.length()) ? 0 : _M_text[_M_pos + 1];
+        while(_M_pos + 1 >= _M_length)
+        {
+            if (!refill())
+                return 0;
+        }
+        return _M_data[_M_pos + 1];
+    }
+
+    bool lexer::at_end()
+    {
+        return _M_pos >= _M_length && !refill();
+    }
+
+    bool lexer::refill()
+    {
+        if (!_M_source)
+            return false;
+        //Keep the current token, it may continue past the end of the buffer. The 
+        //newlines of the text that is discarded have to be indexed now.
+        if (_M_indexed < _M_buffer_offset + _M_start)
+            index_newlines(_M_buffer_offset + _M_start);
+        _M_text.erase(0, _M_start);
+        _M_buffer_offset += _M_start;
+        _M_pos -= _M_start;
+        _M_start = 0;
+        size_t old_length = _M_text.length();
+        _M_text.resize(old_length + _M_buffer_size);
+        size_t n = _M_source(&_M_text[old_length], _M_buffer_size);
+        _M_text.resize(old_length + n);
+        _M_data = _M_text.data();
+        _M_length = _M_text.length();
+        if (n == 0)
+        {
+            _M_source = read_callback_t();
+            return false;
+        }
+        return true;
+    }
+
+    token_t lexer::error_token()
+    {
+        if (!at_end())
+            ++_M_pos;
+        return make_token(token_type::tl_ERROR);
     }
 
-    token_t lexer::make_token(token_type type, const std::string& value)
+    token_t lexer::make_token(token_type type)
     {
-        index_t start_col = _M_col - value.length();
-        return token_t(_M_line, start_col, _M_col, type, value);
+        index_t length = _M_pos - _M_start;
+        token_t tok(_M_buffer_offset + _M_start, length, type);
+    #ifdef LEXER_OWNING_TOKENS
+        tok._M_val.assign(_M_data + _M_start, length);
+    #endif
+        return tok;
     }
 } // namespace lexer
@@ -0,0 +1,226 @@
+#ifndef LEXER_TEMPLATE_SKELETON_HH
+#define LEXER_TEMPLATE_SKELETON_HH 1
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace lexer
+{
+    enum class token_type {
+
+    };
+
+    typedef size_t index_t;
+
+    //A token refers to its text by its offset and length in the lexer's input
+    struct token_t
+    {
+        index_t _M_offset;
+        index_t _M_length;
+        token_type _M_type;
+    };
+
+    //The type of a token lexed at compile time and the offset just past it
+    struct match_t
+    {
+        constexpr match_t(token_type type, index_t end)
+            : _M_type(type), _M_end(end)
+        {
+
+        }
+
+        token_type _M_type;
+        index_t _M_end;
+    };
+
+    //A lexer driven by the compressed DFA tables in Tables. Everything is defined in
+    //this header, so the compiler can specialize and inline the scanner into the code
+    //that uses it, and the constexpr members can lex strings at compile time.
+    //
+    //Tables must provide the comb vectors tl_base, tl_default, tl_next, and tl_check
+    //and tl_accept, the token produced in each state (tl_ERROR if the state does
+    //not accept).
+    template<class Tables>
+    class basic_lexer
+    {
+        public:
+            //Lexes a copy of the string
+            explicit basic_lexer(const std::string& text)
+                : _M_pos(0), _M_start(0), _M_text(text), _M_data(nullptr), _M_length(text.length()), _M_owns_text(true)
+            {
+                _M_data = _M_text.data();
+            }
+
+            //Lexes the characters [data, data + length) in place. data[length] must be
+            //a NUL; the scanner relies on it instead of checking the length.
+            basic_lexer(const char* data, index_t length)
+                : _M_pos(0), _M_start(0), _M_text(), _M_data(data), _M_length(length), _M_owns_text(false)
+            {
+
+            }
+
+            basic_lexer(basic_lexer&& other)
+                : _M_pos(other._M_pos), _M_start(other._M_start), _M_text(std::move(other._M_text)),
+                  _M_data(other._M_data), _M_length(other._M_length), _M_owns_text(other._M_owns_text)
+            {
+                if (_M_owns_text)
+                    _M_data = _M_text.data();
+            }
+
+            basic_lexer(const basic_lexer&) = delete;
+
+            basic_lexer& operator=(const basic_lexer&) = delete;
+
+            token_t next_token();
+
+            std::vector<token_t> tokenize();
+
+            //Returns a pointer to the text of a token produced by this lexer
+            const char* data(const token_t& t) const
+            {
+                return _M_data + t._M_offset;
+            }
+
+            //Returns a copy of the text of a token produced by this lexer
+            std::string text(const token_t& t) const
+            {
+                return std::string(data(t), t._M_length);
+            }
+        #if __cplusplus >= 201703L
+            //Returns the text of a token produced by this lexer without copying it
+            std::string_view view(const token_t& t) const
+            {
+                return std::string_view(data(t), t._M_length);
+            }
+        #endif
+
+            //Returns true for the characters isspace accepts in the "C" locale
+            static constexpr bool is_space(char c)
+            {
+                return c == ' ' || (c >= '\t' && c <= '\r');
+            }
+
+            //Returns the next state of the DFA or a negative number if there is none
+            static constexpr int step(int state, char c)
+            {
+                return (Tables::tl_check[Tables::tl_base[state] + static_cast<unsigned char>(c)] == state)
+                    ? Tables::tl_next[Tables::tl_base[state] + static_cast<unsigned char>(c)]
+                    : Tables::tl_default[state];
+            }
+
+            //Lexes the first token of a NUL terminated string the same way next_token
+            //would. Can be used in constant expressions.
+            static constexpr match_t first_token(const char* s)
+            {
+                return start_token(s, skip_space(s, 0));
+            }
+
+            //Returns true if the whole string is a single token of the specified type.
+            //Can be used in constant expressions.
+            static constexpr bool matches(const char* s, token_type type)
+            {
+                return first_token(s)._M_type == type && s[first_token(s)._M_end] == 0;
+            }
+        private:
+            static constexpr index_t skip_space(const char* s, index_t i)
+            {
+                return is_space(s[i]) ? skip_space(s, i + 1) : i;
+            }
+
+            static constexpr match_t start_token(const char* s, index_t i)
+            {
+                return (s[i] == 0) ? match_t(token_type::tl_EOF, i) : scan(s, i, 0);
+            }
+
+            static constexpr match_t scan(const char* s, index_t i, int state)
+            {
+                return is_space(s[i])
+                    ? ((Tables::tl_accept[state] != token_type::tl_ERROR)
+                        ? match_t(Tables::tl_accept[state], i)
+                        : match_t(token_type::tl_ERROR, i + 1))
+                    : (step(state, s[i]) >= 0)
+                        ? scan(s, i + 1, step(state, s[i]))
+                        : (Tables::tl_accept[state] != token_type::tl_ERROR)
+                            ? match_t(Tables::tl_accept[state], i)
+                            : match_t(token_type::tl_ERROR, (s[i] == 0) ? i : i + 1);
+            }
+
+            token_t make_token(token_type type) const
+            {
+                token_t tok;
+                tok._M_offset = _M_start;
+                tok._M_length = _M_pos - _M_start;
+                tok._M_type = type;
+                return tok;
+            }
+        private:
+            index_t _M_pos;
+            index_t _M_start;
+            //Holds the characters of string input
+            std::string _M_text;
+            //The characters being lexed, followed by a NUL sentinel
+            const char* _M_data;
+            index_t _M_length;
+            bool _M_owns_text;
+    };
+
+    template<class Tables>
+    token_t basic_lexer<Tables>::next_token()
+    {
+        while(is_space(_M_data[_M_pos]))
+            ++_M_pos;
+        _M_start = _M_pos;
+        if (_M_pos >= _M_length)
+            return make_token(token_type::tl_EOF);
+        int state = 0;
+        while(true)
+        {
+            char c = _M_data[_M_pos];
+            token_type accept = Tables::tl_accept[state];
+            //Whitespace ends a token before any transition is taken, like in the goto code 
+            //of a generated lexer
+            if (is_space(c))
+            {
+                if (accept != token_type::tl_ERROR)
+                    return make_token(accept);
+                ++_M_pos;
+                return make_token(token_type::tl_ERROR);
+            }
+            int next = step(state, c);
+            if (next >= 0)
+            {
+                ++_M_pos;
+                state = next;
+                continue;
+            }
+            if (accept != token_type::tl_ERROR)
+                return make_token(accept);
+            if (_M_pos < _M_length)
+                ++_M_pos;
+            return make_token(token_type::tl_ERROR);
+        }
+    }
+
+    template<class Tables>
+    std::vector<token_t> basic_lexer<Tables>::tokenize()
+    {
+        std::vector<token_t> tokens;
+        while(true)
+        {
+            tokens.push_back(next_token());
+            if (tokens.back()._M_type == token_type::tl_EOF)
+                return tokens;
+        }
+    }
+
+    //Generated tables
+}
+
+//Generated self-test
+
+#endif
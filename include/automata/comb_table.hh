@@ -0,0 +1,147 @@
+#ifndef COMB_TABLE_HH
+#define COMB_TABLE_HH 1
+
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <ostream>
+
+#include "dfa.hh"
+
+namespace final_project
+{
+    namespace automata
+    {
+        //A transition table compressed with row displacement (a "comb vector").
+        //Every row keeps only the entries that differ from its default value. The
+        //rows are overlapped in the _M_next/_M_check vectors so that the entry for
+        //(row, column) lives at _M_base[row] + column when _M_check says it belongs
+        //to that row; otherwise the row's default value applies.
+        //
+        //The _M_next and _M_check vectors are padded so that any column of any row
+        //can be looked up without a bounds check.
+        struct comb_table
+        {
+            //The type of an uncompressed table, one vector of columns per row
+            typedef std::vector<std::vector<state_t>> dense_table_t;
+
+            //Returns the value stored at the specified row and column
+            //
+            //@param row the row to look up
+            //@param column the column to look up
+            //@return the value at (row, column)
+            state_t lookup(state_t row, size_t column) const;
+
+            //Returns the number of entries stored by the compressed table
+            //
+            //@return the size of base, default, next, and check combined
+            size_t size() const;
+
+            //Returns the number of entries the uncompressed table had
+            //
+            //@return rows * columns of the original table
+            size_t dense_size() const;
+
+            //Returns the size of the uncompressed table divided by the size
+            //of the compressed table
+            //
+            //@return the compression ratio
+            double compression_ratio() const;
+
+            //The number of columns in the uncompressed table
+            size_t _M_columns;
+            //The offset of each row into _M_next and _M_check
+            std::vector<state_t> _M_base;
+            //The value of every entry of a row that was not stored
+            std::vector<state_t> _M_default;
+            //The stored entries of all rows
+            std::vector<state_t> _M_next;
+            //The row that owns each entry of _M_next or -1 if the slot is empty
+            std::vector<state_t> _M_check;
+        };
+
+        inline state_t comb_table::lookup(state_t row, size_t column) const
+        {
+            size_t i = _M_base[row] + column;
+            return (_M_check[i] == row) ? _M_next[i] : _M_default[row];
+        }
+
+        //Compresses the specified table with row displacement. The most common value
+        //of each row becomes its default and the remaining entries are packed into
+        //the comb vectors with a first-fit search, densest rows first.
+        //
+        //@param dense the table to compress; all rows must have the same length
+        //@return the compressed table
+        comb_table compress_table(const comb_table::dense_table_t& dense);
+
+        //Compresses the specified table with row displacement, keeping only the entries 
+        //of each row that differ from the specified default of the row.
+        //
+        //@param dense the table to compress; all rows must have the same length
+        //@param defaults the default value of each row
+        //@return the compressed table
+        comb_table compress_table(const comb_table::dense_table_t& dense, const std::vector<state_t>& defaults);
+
+        //Removes every row of a table that repeats an earlier row, so that the rows 
+        //of the compressed table can be shared.
+        //
+        //@param dense the table; on return it holds each distinct row once, in the order 
+        //the rows first appeared
+        //@return the index in the new table of each row of the original table
+        std::vector<state_t> merge_identical_rows(comb_table::dense_table_t& dense);
+
+        //Expands a DFA over characters into a dense table with one column for
+        //every unsigned char.
+        //
+        //@param d the DFA to expand
+        //@param error the value to use for missing transitions
+        //@return the dense transition table
+        comb_table::dense_table_t make_dense_table(const dfa<char>& d, state_t error);
+
+        //Expands a DFA into a dense table using the specified column for each symbol.
+        //Symbols without a column are ignored.
+        //
+        //@param d the DFA to expand
+        //@param columns the column assigned to each symbol
+        //@param error the value to use for missing transitions
+        //@return the dense transition table
+        template<typename _TokTp>
+        comb_table::dense_table_t make_dense_table(const dfa<_TokTp>& d,
+            const std::unordered_map<_TokTp, size_t>& columns, state_t error)
+        {
+            const auto& transitions = d.get_table();
+            comb_table::dense_table_t dense(transitions.size(), std::vector<state_t>(columns.size(), error));
+            for(size_t i = 0; i < transitions.size(); ++i)
+            {
+                for(const auto& transition: transitions[i])
+                {
+                    auto it = columns.find(transition.first);
+                    if (it != columns.end())
+                        dense[i][it->second] = transition.second;
+                }
+            }
+            return dense;
+        }
+
+        //Returns the smallest C++ integer type that can hold every value in
+        //the compressed table. Used when emitting the table as source code.
+        //
+        //@param table the compressed table
+        //@return the name of the type, e.g. "short"
+        std::string element_type(const comb_table& table);
+
+        //Writes the vectors of the compressed table as C++ array definitions named
+        //<prefix>_base, <prefix>_default, <prefix>_next, and <prefix>_check.
+        //
+        //@param os the stream to write to
+        //@param table the compressed table
+        //@param prefix the prefix of the array names
+        //@param indent the indentation to put before each definition
+        //@param qualifiers the specifiers written before the type of each array
+        void print_comb_table(std::ostream& os, const comb_table& table, const std::string& prefix,
+            const std::string& indent, const std::string& qualifiers = "static const");
+    } // namespace automata
+
+} // namespace final_project
+
+#endif
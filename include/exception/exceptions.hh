@@ -39,6 +39,22 @@ namespace final_project
         private:
             std::string _M_message;
     };
+
+    //Thrown when a lexer profile cannot be read or was recorded with a different DFA.
+    struct invalid_profile_exception : public std::exception 
+    {
+        public: 
+            invalid_profile_exception(const std::string& message);
+
+            const char* what() const throw();
+
+            ~invalid_profile_exception() throw()
+            {
+
+            }
+        private:
+            std::string _M_message;
+    };
     }
 } // namespace final_project::exceptions
 
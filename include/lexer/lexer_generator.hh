@@ -2,20 +2,88 @@
 #define LEXER_GENERATOR_HH 1
 
 #include <string>
+#include <istream>
+#include <map>
+#include <vector>
+
+#include "automata/dfa.hh"
 
 namespace final_project
 {
     namespace lexer
     {
+        //Options that control the code the lexer generator emits
+        struct lexer_options
+        {
+            lexer_options()
+                : _M_compress_tables(false), _M_report_compression(false), _M_simd_self_loops(true),
+                  _M_owning_tokens(false), _M_header_only(false), _M_profile()
+            {
+
+            }
+
+            //Emit the DFA as row displacement compressed tables driven by a
+            //loop instead of one block of goto statements per state
+            bool _M_compress_tables;
+            //Print the size of the compressed DFA table compared to a dense table
+            bool _M_report_compression;
+            //Emit SSE2/AVX2 loops that skip runs of characters on which a state 
+            //transitions back to itself. Only applies to the goto code.
+            bool _M_simd_self_loops;
+            //Store a copy of each token's text in the token. By default tokens 
+            //only refer to the lexer's input by offset and length.
+            bool _M_owning_tokens;
+            //Emit a single header, lexer.hh, that holds the DFA as constexpr compressed 
+            //tables and a basic_lexer template driving them, plus static_assert checks 
+            //that sample tokens lex correctly at compile time. No lexer.cpp is written.
+            bool _M_header_only;
+            //A profile written by lexer::write_profile from a lexer built with LEXER_PROFILE 
+            //defined. The goto code then tests the most taken transitions first, places the 
+            //most visited states together, and moves the error paths out of line. Empty 
+            //for no profile; ignored for compressed tables and the header only lexer.
+            std::string _M_profile;
+        };
+
+        //The keywords of each identifier rule, declared after the regular expressions 
+        //with lines of the form 
+        //    keywords <rule>: <keyword> <keyword> ...
+        //Every keyword is a token type of its own, so it has to be an identifier. Text 
+        //matched by the rule is lexed as a keyword if it is equal to one, so the keywords 
+        //do not need states in the DFA.
+        typedef std::map<std::string, std::vector<std::string>> keyword_sets_t;
+
+        //Reads in a set of regular expressions and keyword declarations from the 
+        //specified stream and builds the DFA that recognizes their tokens. Throws 
+        //exceptions::invalid_regex_exception if a rule's list of keywords is empty, or a 
+        //keyword is not an identifier, is not matched by its rule, or has the name of 
+        //another token.
+        //
+        //@param in the stream containing the regular expressions
+        //@param keywords set to the keywords declared in the stream
+        //@param expand_keywords add a regular expression for every keyword ahead of its 
+        //rule, so the DFA recognizes the keywords itself
+        //@return the DFA of the lexer
+        automata::dfa<char> build_dfa(std::istream& in, keyword_sets_t& keywords, bool expand_keywords);
+
+        //Reads in a set of regular expressions from the specified stream and 
+        //builds the DFA that recognizes their tokens, keywords included
+        //
+        //@param in the stream containing the regular expressions
+        //@return the DFA of the lexer
+        automata::dfa<char> build_dfa(std::istream& in);
+
         //Reads in a set of regular expressions from the specified file 
         //and generates a lexer that can split a string into tokens based 
         //on the regular expressions.
         //
         //Creates two files for the lexer: lexer.hh which is the header file 
-        //for the lexer and lexer.cpp which is the implementation of the lexer
+        //for the lexer and lexer.cpp which is the implementation of the lexer. 
+        //With the header only option lexer.hh is generated from 
+        //lexer_template_skeleton.hh instead and is the only file created.
         //
         //@param filename the name of the file containing the regular expressions
-        void generate_lexer(const std::string& filename);
+        //@param options the options controlling the generated code
+        void generate_lexer(const std::string& filename, const lexer_options& options = lexer_options());
     } // namespace lexer
        
 } // namespace final_project::lexer
@@ -0,0 +1,59 @@
+#ifndef LEXER_JIT_HH
+#define LEXER_JIT_HH 1
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace final_project
+{
+    namespace lexer
+    {
+        //Native x86-64 code for the DFA of a runtime_lexer. Every state becomes a block
+        //of code that loads the current character and compares it against the ranges of
+        //characters the state has transitions on; a match moves past the character and
+        //jumps straight to the block of the next state. When no range matches, the code
+        //stores the state and returns a pointer to the character it stopped at.
+        //
+        //The code is written to an anonymous mapping that is made executable once it is
+        //complete. Only x86-64 with the System V calling convention is supported; on
+        //other machines, or if executable memory cannot be allocated, nothing is
+        //compiled and function() returns nullptr.
+        class lexer_jit
+        {
+            public:
+                //Runs the DFA from the start state on the characters at p and returns a
+                //pointer to the first character without a transition. The state the
+                //DFA stopped in is stored in *state.
+                typedef const char* (*scan_function_t)(const char* p, int32_t* state);
+
+                //Compiles the table of a runtime_lexer
+                //
+                //@param next the next state for each state and character class, stored as
+                //the offset of the state's row or -1 if there is no transition
+                //@param classes the class of each unsigned char
+                //@param num_classes the number of classes, the width of a row
+                lexer_jit(const std::vector<int32_t>& next, const std::vector<uint8_t>& classes, size_t num_classes);
+
+                lexer_jit(const lexer_jit&) = delete;
+
+                lexer_jit& operator=(const lexer_jit&) = delete;
+
+                ~lexer_jit();
+
+                //Returns the compiled code or nullptr if the DFA was not compiled
+                scan_function_t function() const;
+
+                //Returns the number of bytes of code generated
+                size_t code_size() const;
+            private:
+                void* _M_code;
+                size_t _M_mapping_length;
+                size_t _M_code_size;
+                scan_function_t _M_function;
+        };
+    } // namespace lexer
+
+} // namespace final_project
+
+#endif
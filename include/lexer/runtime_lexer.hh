@@ -0,0 +1,108 @@
+#ifndef RUNTIME_LEXER_HH
+#define RUNTIME_LEXER_HH 1
+
+#include "automata/dfa.hh"
+#include "lexer/lexer_jit.hh"
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <cstdint>
+#include <memory>
+
+namespace final_project
+{
+    namespace lexer
+    {
+        //A lexer compiled in memory from regular expressions in the format read by
+        //generate_lexer, for programs that load token specifications at run time and
+        //cannot compile generated code. It produces the same tokens as a generated lexer.
+        //
+        //The DFA is interpreted from a dense table with one row per state and one column
+        //per character class, where characters that every state treats alike share a
+        //class. Whitespace has no transitions, so the end of a token is found without
+        //testing for whitespace in the inner loop.
+        //
+        //Optionally the table is also compiled to native code with lexer_jit, which runs
+        //at the speed of a generated goto lexer. The table interpreter is used whenever
+        //the code could not be compiled.
+        //
+        //A runtime_lexer does not change once it is constructed, so one instance can lex
+        //any number of inputs from any number of threads. Copies share the native code.
+        class runtime_lexer
+        {
+            public:
+                //A token refers to its text by its offset and length in the input
+                struct token_t
+                {
+                    size_t _M_offset;
+                    size_t _M_length;
+                    //An index into token_names()
+                    size_t _M_type;
+                };
+
+                //Compiles the regular expressions read from the specified stream
+                //
+                //@param spec the stream to read the regular expressions from
+                //@param jit compile the DFA to native code if the machine supports it
+                explicit runtime_lexer(std::istream& spec, bool jit = false);
+
+                //Compiles the specified DFA
+                //
+                //@param d a DFA created by powerset_construction
+                //@param jit compile the DFA to native code if the machine supports it
+                explicit runtime_lexer(const automata::dfa<char>& d, bool jit = false);
+
+                //Returns the name of each token type, indexed by type. The labels of the
+                //regular expressions come first in sorted order, followed by "EOF" and
+                //"ERROR", the same order as the token_type enum of a generated lexer.
+                //
+                //@return the names of the token types
+                const std::vector<std::string>& token_names() const;
+
+                //Returns the type of the token returned at the end of the input
+                size_t eof_type() const;
+
+                //Returns the type of the token returned for characters that do not
+                //start any token
+                size_t error_type() const;
+
+                //Returns the number of character classes the table is indexed by
+                size_t num_classes() const;
+
+                //Returns true if tokens are lexed by native code rather than the table interpreter
+                bool is_jit() const;
+
+                //Lexes the token that starts at pos, after any whitespace, and moves
+                //pos past it. data[length] must be a NUL; std::string provides one.
+                //
+                //@param data the input
+                //@param length the number of characters in the input
+                //@param pos the position to start at
+                //@return the token, or an EOF token at the end of the input
+                token_t next_token(const char* data, size_t length, size_t& pos) const;
+
+                //Lexes the token that starts at pos in the specified string
+                token_t next_token(const std::string& text, size_t& pos) const;
+
+                //Lexes the whole string. The last token is the EOF token.
+                std::vector<token_t> tokenize(const std::string& text) const;
+            private:
+                std::vector<std::string> _M_names;
+                //The class of each unsigned char
+                std::vector<uint8_t> _M_classes;
+                size_t _M_num_classes;
+                //The next state for each state and class, stored as the offset of the
+                //state's row, or -1 if there is no transition
+                std::vector<int32_t> _M_next;
+                //The token produced in each state, error_type() if it does not accept
+                std::vector<size_t> _M_accept;
+                //The native code of the DFA and its entry point, nullptr if not compiled
+                std::shared_ptr<lexer_jit> _M_jit;
+                lexer_jit::scan_function_t _M_scan;
+        };
+    } // namespace lexer
+
+} // namespace final_project
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef DYNAMIC_BITSET_HH
+#define DYNAMIC_BITSET_HH 1
+
+#include <vector>
+#include <bitset>
+#include <cstdint>
+#include <cstddef>
+
+namespace final_project
+{
+    namespace parser
+    {
+        //A set of small integers, such as productions or symbols, stored one bit per
+        //element in 64-bit words. The parser generator uses it for closures and lookahead
+        //sets, where a union of two sets is a loop of word ORs.
+        class dynamic_bitset
+        {
+            public:
+                dynamic_bitset() = default;
+
+                //Creates an empty set of the integers 0 to size - 1
+                explicit dynamic_bitset(size_t size)
+                    : _M_size(size), _M_words((size + 63) / 64, 0)
+                {
+
+                }
+
+                //Returns the number of integers the set can hold
+                size_t size() const
+                {
+                    return _M_size;
+                }
+
+                void set(size_t i)
+                {
+                    _M_words[i / 64] |= uint64_t(1) << (i % 64);
+                }
+
+                void reset(size_t i)
+                {
+                    _M_words[i / 64] &= ~(uint64_t(1) << (i % 64));
+                }
+
+                bool test(size_t i) const
+                {
+                    return (_M_words[i / 64] >> (i % 64)) & 1;
+                }
+
+                //Removes every element
+                void clear()
+                {
+                    for(auto& word: _M_words)
+                        word = 0;
+                }
+
+                //Returns true if the set has no elements
+                bool none() const
+                {
+                    for(auto word: _M_words)
+                    {
+                        if (word)
+                            return false;
+                    }
+                    return true;
+                }
+
+                //Returns the number of elements
+                size_t count() const
+                {
+                    size_t n = 0;
+                    for(auto word: _M_words)
+                        n += popcount(word);
+                    return n;
+                }
+
+                //Adds the elements of the specified set, which must be the same size
+                //
+                //@param other the set to add
+                //@return true if an element was added
+                bool merge(const dynamic_bitset& other)
+                {
+                    uint64_t added = 0;
+                    for(size_t i = 0; i < _M_words.size(); ++i)
+                    {
+                        added |= other._M_words[i] & ~_M_words[i];
+                        _M_words[i] |= other._M_words[i];
+                    }
+                    return added != 0;
+                }
+
+                //Returns true if the sets have an element in common
+                bool intersects(const dynamic_bitset& other) const
+                {
+                    for(size_t i = 0; i < _M_words.size(); ++i)
+                    {
+                        if (_M_words[i] & other._M_words[i])
+                            return true;
+                    }
+                    return false;
+                }
+
+                //Returns the smallest element that is at least i, or size() if there is none
+                size_t next(size_t i) const
+                {
+                    if (i >= _M_size)
+                        return _M_size;
+                    size_t w = i / 64;
+                    uint64_t word = _M_words[w] & (~uint64_t(0) << (i % 64));
+                    while(!word)
+                    {
+                        if (++w == _M_words.size())
+                            return _M_size;
+                        word = _M_words[w];
+                    }
+                    return w * 64 + lowest_set_bit(word);
+                }
+
+                //Calls f with each element in increasing order
+                template<class _Function>
+                void for_each(_Function f) const
+                {
+                    for(size_t w = 0; w < _M_words.size(); ++w)
+                    {
+                        for(uint64_t word = _M_words[w]; word; word &= word - 1)
+                            f(w * 64 + lowest_set_bit(word));
+                    }
+                }
+
+                bool operator==(const dynamic_bitset& other) const
+                {
+                    return _M_size == other._M_size && _M_words == other._M_words;
+                }
+
+                bool operator!=(const dynamic_bitset& other) const
+                {
+                    return !(*this == other);
+                }
+            private:
+                //Returns the number of bits set in the word
+                static size_t popcount(uint64_t word)
+                {
+                #if defined(__GNUC__)
+                    return __builtin_popcountll(word);
+                #else
+                    return std::bitset<64>(word).count();
+                #endif
+                }
+
+                //Returns the index of the lowest set bit of a non-zero word
+                static size_t lowest_set_bit(uint64_t word)
+                {
+                #if defined(__GNUC__)
+                    return __builtin_ctzll(word);
+                #else
+                    size_t i = 0;
+                    for(; !(word & 1); word >>= 1)
+                        ++i;
+                    return i;
+                #endif
+                }
+
+                size_t _M_size = 0;
+                std::vector<uint64_t> _M_words;
+        };
+    } // namespace parser
+} // namespace final_project
+
+#endif
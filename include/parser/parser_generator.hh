@@ -2,6 +2,9 @@
 #define PARSER_GENERATOR_HH 1
 
 #include "automata/dfa.hh"
+#include "automata/comb_table.hh"
+#include "parser/symbol_table.hh"
+#include "parser/dynamic_bitset.hh"
 
 #include <string>
 #include <vector>
@@ -21,59 +24,77 @@ namespace final_project
         const static char EPSILON = 0;
         const static std::string TP_EOF = "$";
         const static automata::state_t TP_ACCEPT = std::numeric_limits<automata::state_t>::max();
+        const static automata::state_t TP_ERROR = std::numeric_limits<automata::state_t>::min();
 
+        //Generates LALR(1) parse tables. Grammar symbols are interned in a symbol_table 
+        //when the grammar is read and every stage works on their ids; the names are 
+        //only looked up again to build the tables that are returned.
         class parser_generator
         {
             public:
+                //A production of the grammar
                 struct rule_t
                 {
-                    size_t _M_pointer;
-                    std::string _M_lhs;
-                    std::vector<std::string> _M_rhs;
+                    symbol_t _M_lhs;
+                    std::vector<symbol_t> _M_rhs;
                     //std::vector<std::string> _M_node_types;
+                };
 
-                    rule_t& operator++()
-                    {
-                        ++_M_pointer;
-                        return *this;
-                    }
-
-                    rule_t operator++(int)
-                    {
-                        rule_t temp(*this);
-                        ++_M_pointer;
-                        return temp;
-                    }
+                //An LR(0) item: the index of a production in the grammar and the position 
+                //of the dot in its right hand side packed into one integer, so that items 
+                //order by production and then by dot and advancing the dot is an increment
+                typedef uint32_t item_t;
 
-                };
+                //The number of low bits of an item that hold the dot
+                static const unsigned ITEM_DOT_BITS = 10;
 
                 struct item_set_t
                 {
-                    std::set<rule_t> _M_rules;
+                    //The items of the set in increasing order
+                    std::vector<item_t> _M_items;
 
-                    bool add_rule(const rule_t& rule)
+                    bool add_item(item_t item)
                     {
-                        size_t old_size = _M_rules.size();
-                        _M_rules.insert(rule);
-                        return _M_rules.size() != old_size;
+                        auto it = std::lower_bound(_M_items.begin(), _M_items.end(), item);
+                        if (it != _M_items.end() && *it == item)
+                            return false;
+                        _M_items.insert(it, item);
+                        return true;
                     }
 
-                    bool has_rule(const rule_t& rule) const 
+                    bool has_item(item_t item) const 
                     {
-                        return std::find(_M_rules.begin(), _M_rules.end(), rule) != _M_rules.end();
+                        return std::binary_search(_M_items.begin(), _M_items.end(), item);
                     }
 
-                    [[gnu::noinline]]
-                    size_t num_rules() const 
+                    size_t num_items() const 
                     {
-                        return _M_rules.size();
+                        return _M_items.size();
                     }
                 };
+
+                //Returns the item of the specified production with the dot at the specified position
+                static item_t make_item(size_t production, size_t dot)
+                {
+                    return static_cast<item_t>((production << ITEM_DOT_BITS) | dot);
+                }
+
+                //Returns the index of the production of the specified item
+                static size_t item_production(item_t item)
+                {
+                    return item >> ITEM_DOT_BITS;
+                }
+
+                //Returns the position of the dot of the specified item
+                static size_t item_dot(item_t item)
+                {
+                    return item & ((1u << ITEM_DOT_BITS) - 1);
+                }
             
                 struct extended_rule_t
                 {
                     //Represents a symbol in the extended grammar 
-                    typedef std::pair<std::string, std::pair<size_t, size_t>> symbol;
+                    typedef std::pair<symbol_t, std::pair<size_t, size_t>> symbol;
                     symbol _M_lhs;
                     std::vector<symbol> _M_rhs;
 
@@ -85,106 +106,303 @@ namespace final_project
                     }
                 };
 
-                struct symbol_hash
+                //Hashes the kernel of an item set, its items in increasing order
+                struct kernel_hash
                 {
-                    size_t operator()(const extended_rule_t::symbol& s) const 
+                    size_t operator()(const std::vector<item_t>& kernel) const 
                     {
-                        auto lhs = s.first;
-                        auto rhs = s.second;
                         size_t hash = 0;
-                        hash ^= std::hash<std::string>{}(lhs) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-                        hash ^= rhs.first  + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-                        hash ^= rhs.second  + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+                        for(item_t item: kernel)
+                            hash ^= item + 0x9e3779b9 + (hash << 6) + (hash >> 2);
                         return hash;
                     } 
                 };
 
-                typedef std::vector<std::unordered_map<std::string, size_t>> translation_table_t;
+                //A rule of the extended grammar with its symbols replaced by their numbers, and 
+                //the production it extends
+                struct numbered_rule_t
+                {
+                    size_t _M_production;
+                    size_t _M_lhs;
+                    std::vector<size_t> _M_rhs;
+                };
+
+                typedef std::vector<std::unordered_map<symbol_t, size_t>> translation_table_t;
+
+                //How create_parse_tables computes the LALR(1) lookaheads
+                enum lookahead_method_t
+                {
+                    //DeRemer and Pennello's Read and Includes relations over the nonterminal 
+                    //transitions, solved with bitsets in time linear in the relations
+                    LA_DEREMER_PENNELLO,
+                    //FIRST and FOLLOW sets of a grammar that has one extended rule for every 
+                    //state and production, which can be many times larger than the grammar
+                    LA_EXTENDED_GRAMMAR,
+                    //LR(1) states whose items carry lookaheads, merging states with the same 
+                    //LR(0) kernel when Pager's weak compatibility test shows no reduce/reduce 
+                    //conflict can result. The tables have the power of canonical LR(1) with 
+                    //close to the number of states of LALR(1).
+                    LA_PAGER_LR1,
+                    //Canonical LR(1) states, which are only merged if their lookaheads are equal
+                    LA_CANONICAL_LR1
+                };
+
+                //A reduction of a state: the production reduced and the symbols it is reduced on
+                struct reduction_t
+                {
+                    size_t _M_production;
+                    dynamic_bitset _M_lookaheads;
+                };
+
+                //The kind of an action of the compressed action table
+                enum action_kind_t
+                {
+                    PA_ERROR,
+                    PA_SHIFT,
+                    PA_REDUCE,
+                    PA_ACCEPT
+                };
+
+                //An action packed into 32 bits: the kind of action in the two low bits and the 
+                //state shifted to or the production reduced in the rest. An error is 0.
+                typedef uint32_t packed_action_t;
+
+                //The number of low bits of a packed action that hold its kind
+                static const unsigned ACTION_KIND_BITS = 2;
+
+                //Returns the packed form of an action of the action table returned by 
+                //create_parse_tables
+                static packed_action_t pack_action(automata::state_t action)
+                {
+                    if (action == TP_ERROR)
+                        return PA_ERROR;
+                    if (action == TP_ACCEPT)
+                        return PA_ACCEPT;
+                    if (action >= 0)
+                        return (static_cast<packed_action_t>(action) << ACTION_KIND_BITS) | PA_SHIFT;
+                    return (static_cast<packed_action_t>(-action) << ACTION_KIND_BITS) | PA_REDUCE;
+                }
+
+                //Returns the kind of the specified packed action
+                static action_kind_t action_kind(packed_action_t action)
+                {
+                    return static_cast<action_kind_t>(action & ((1u << ACTION_KIND_BITS) - 1));
+                }
+
+                //Returns the state shifted to or the production reduced by the specified packed action
+                static size_t action_value(packed_action_t action)
+                {
+                    return action >> ACTION_KIND_BITS;
+                }
+
+                //The action and goto tables compacted for a table driven parser. 
+                //
+                //Each row of the action table is given a default reduction, the reduction it 
+                //makes on the most terminals, which also replaces the row's errors; a parser 
+                //then reduces before it finds an error but never shifts past one. States whose 
+                //rows are then the same share a row, and the rows are compressed with row 
+                //displacement. 
+                //
+                //The goto table is stored by nonterminal, since a nonterminal goes to few 
+                //different states. Each nonterminal's most common state is its default and 
+                //also stands in for the missing gotos, which a parser never looks up.
+                struct compressed_tables_t
+                {
+                    //Returns the packed action of the specified state on the terminal of the specified column
+                    packed_action_t action(size_t state, size_t column) const
+                    {
+                        return static_cast<packed_action_t>(_M_action.lookup(_M_action_rows[state], column));
+                    }
+
+                    //Returns the state the specified state goes to on the nonterminal of the specified column
+                    automata::state_t goto_state(size_t state, size_t column) const
+                    {
+                        return _M_goto.lookup(_M_goto_rows[column], state);
+                    }
+
+                    //Returns the number of entries stored for the action table, including the row of each state
+                    size_t action_size() const
+                    {
+                        return _M_action_rows.size() + _M_action.size();
+                    }
+
+                    //Returns the number of entries stored for the goto table, including the row of each nonterminal
+                    size_t goto_size() const
+                    {
+                        return _M_goto_rows.size() + _M_goto.size();
+                    }
+
+                    //The terminal of each column of the action table
+                    std::vector<std::string> _M_action_columns;
+                    //The nonterminal of each column of the goto table
+                    std::vector<std::string> _M_goto_columns;
+                    //The row of _M_action that holds the actions of each state
+                    std::vector<automata::state_t> _M_action_rows;
+                    //The distinct rows of packed actions, one column per terminal
+                    automata::comb_table _M_action;
+                    //The row of _M_goto that holds the gotos on each nonterminal
+                    std::vector<automata::state_t> _M_goto_rows;
+                    //The distinct rows of gotos, one per nonterminal with one column per state
+                    automata::comb_table _M_goto;
+                };
             public:
                 //Constructs a parser generator that reads in a context free grammar from the specified 
                 //input stream 
                 //
                 //@param in the input stream from which to read the context free grammar
-                explicit parser_generator(std::istream& in);
+                //@param method how to compute the lookaheads
+                explicit parser_generator(std::istream& in, lookahead_method_t method = LA_DEREMER_PENNELLO);
 
-                //Creates the LALR(1) parse tables
+                //Creates the parse tables, LALR(1) or LR(1) depending on the lookahead method. Throws 
+                //std::length_error if the grammar has too many rules or too long a rule for its 
+                //items to be packed.
                 std::pair<automata::dfa<std::string>, automata::dfa<std::string>> create_parse_tables();
 
                 static std::ostream& print_tables(std::ostream& os, const automata::dfa<std::string>& action, 
                     const automata::dfa<std::string>& goto_table);
+
+                //Compacts the action and goto tables with default reductions, shared rows, 
+                //packed actions, and row displacement (see compressed_tables_t)
+                //
+                //@param action the action table 
+                //@param goto_table the goto table 
+                //@return the compressed tables
+                static compressed_tables_t compress_tables(const automata::dfa<std::string>& action, 
+                    const automata::dfa<std::string>& goto_table);
+
+                //Prints the compressed action and goto tables as the row of each state or 
+                //nonterminal and the base, default, next, and check vectors
+                //
+                //@param os the stream to print to 
+                //@param tables the compressed tables
+                static std::ostream& print_compressed_tables(std::ostream& os, const compressed_tables_t& tables);
+
+                //Returns the names of the grammar's symbols 
+                //
+                //@return the symbol table of the grammar
+                const symbol_table& get_symbols() const;
             #ifdef DEBUG
             public:
             #else
             private:
             #endif
-                //Returns true if the string represents a terminal symbol 
-                //@param str the string to evaluate
-                bool is_terminal(const std::string& str) const;
+                //Returns true if the symbol is a terminal symbol 
+                //@param symbol the symbol to evaluate
+                bool is_terminal(symbol_t symbol) const;
+
+                //Returns the symbol after the dot of the specified item or NO_SYMBOL if 
+                //the dot is at the end of the rule
+                symbol_t next_symbol(item_t item) const;
 
                 //Creates the LALR(1) goto table for the specified grammar
                 //
                 //@return the LALR(1) goto table
                 automata::dfa<std::string> create_goto_table();
 
-                //Creates the LALR(1) action table for the specified grammar 
+                //Creates the LALR(1) action table for the specified grammar from the reductions 
+                //created by create_lookaheads or create_extended_lookaheads. A reduction 
+                //replaces a shift on the same symbol, and on a reduce/reduce conflict the 
+                //production that comes first in the grammar is reduced.
                 //
                 //@param sets the grammar's item sets 
                 //@return the LALR(1) action table
                 automata::dfa<std::string> create_action_table(const std::vector<parser_generator::item_set_t>& sets);
 
+                //Creates the reductions of every state with DeRemer and Pennello's algorithm. 
+                //The lookaheads of a nonterminal transition are the terminals it Reads and the 
+                //lookaheads of the transitions it Includes, and a reduction's lookaheads are 
+                //those of the transitions it looks back to.
+                //
+                //@param sets the grammar's item sets
+                void create_lookaheads(const std::vector<parser_generator::item_set_t>& sets);
+
+                //Creates the reductions of every state from the FOLLOW sets of the extended grammar
+                //
+                //@param sets the grammar's item sets
+                void create_extended_lookaheads(const std::vector<parser_generator::item_set_t>& sets);
+
                 //Returns the parser generator's grammar 
                 //
                 //@return the parser generators grammar
                 const std::vector<rule_t>& get_grammar() const;
-                //Creates the item sets for the grammar
+                //Creates the item sets for the grammar and the translation table between them. 
+                //The sets are numbered in the order they are found, so the start state is 0. 
                 //@return the grammar's item sets
                 std::vector<item_set_t> create_item_sets();
 
-                //Creates the translations table for the grammar 
+                //Creates the LR(1) states of the grammar, their translation table, and their reductions. 
+                //A state is a kernel of LR(0) items with a lookahead set for each item. A goto 
+                //whose kernel matches an existing state is merged into it if the state is 
+                //compatible; a state whose lookaheads grow is processed again, which can move 
+                //its transitions to new states. States left unreachable are removed and the 
+                //rest numbered in the order they are reached, so the start state is 0.
+                //
+                //@param merge merge weakly compatible states as well as states with equal lookaheads
+                //@return the LR(0) closures of the states' kernels
+                std::vector<item_set_t> create_lr1_item_sets(bool merge);
+
+                //Creates the translations table for item sets that were not created by 
+                //create_item_sets, which already fills in the table
                 //
                 //@param sets the grammar's item sets
                 void create_translation_table(const std::vector<parser_generator::item_set_t>& sets);
 
-                //Creates an extended grammar for the item sets and translation table
+                //Creates an extended grammar for the item sets and translation table, numbers 
+                //its symbols, and indexes where each symbol occurs
                 //
                 //@param sets the grammar's item sets 
                 void create_extended_grammar(const std::vector<parser_generator::item_set_t>& sets);
-                
-                //Creates the extended grammar's first sets
-                //
-                //@param g the extended grammar 
+
+                //Finds the nullable symbols of the extended grammar. A rule's count of symbols not yet 
+                //known to be nullable drops as they are found, and its left hand side is nullable 
+                //when the count reaches zero, so each occurrence of a symbol is visited once.
+                void compute_nullables();
+
+                //Creates the extended grammar's first sets. Each symbol's set is passed on to the 
+                //left hand sides of the rules it begins, after any nullable symbols, and only when 
+                //the set has grown. compute_nullables must be called first.
                 void create_first_sets();
-                std::set<std::string> first(const extended_rule_t::symbol& s);
-                //Determines the first set for the specified vector of grammar symbols
-                //
-                //@param g the extended grammar 
-                //@param s the vector of grammar symbols 
-                //@return the first set for the vector of grammar symbols
-                std::set<std::string> first(const std::vector<extended_rule_t::symbol>& s);
-                
-                //Determines if the specified grammar symbol is nullable that is
-                //if a -> epsilon
-                //
-                //@param g the extended grammar 
-                //@param s the specified symbol 
-                //@return true if the symbol is nullable
-                bool nullable(const extended_rule_t::symbol& s);
 
-                //Determines if the specifed vector of grammar symbols is nullable 
+                //Creates the extended grammar's follow sets. A symbol's follow set holds the first 
+                //sets of what comes after each of its occurrences, and includes the follow set of 
+                //the rule's left hand side where what comes after is nullable. The occurrences are 
+                //looked up in the index, and the includes relation is solved one strongly connected 
+                //component at a time, so each of its edges is followed once. create_first_sets must 
+                //be called first.
+                void create_follow_sets();
+            private:
+                //Returns the closure of the specified items
+                item_set_t create_item_set(const std::vector<item_t>& kernel);
+
+                //Returns the items of the specified set that are not added by the closure: the start 
+                //item and the items with the dot advanced
+                std::vector<item_t> kernel(const item_set_t& set) const;
+
+                //Advances the dot of every item of the specified set in one pass, grouping the items 
+                //by the symbol they were advanced over. There are no transitions on $ or epsilon.
                 //
-                //@param g the extended grammar 
-                //@param s the specified symbol 
-                //@return true if the vector of grammar symbols is nullable
-                bool nullable(const std::vector<parser_generator::extended_rule_t::symbol>& s);
+                //@param set the item set
+                //@param kernels the goto kernel on each symbol, which must be empty on entry
+                //@param symbols set to the symbols with a goto kernel in increasing order
+                void goto_kernels(const item_set_t& set, std::vector<std::vector<item_t>>& kernels, 
+                    std::vector<symbol_t>& symbols) const;
 
-                void compute_nullables();
-                //Creates the extended grammar's first sets
+                //Creates the closure of the start items of every nonterminal. Throws std::length_error 
+                //if the grammar's items cannot be packed into an item_t.
+                void create_closures();
+
+                //Creates the FIRST set of every symbol of the grammar and finds the nullable symbols
+                void create_symbol_first_sets();
+
+                //Adds the FIRST set of the symbols of rhs from position from onwards to the specified set 
                 //
-                //@param g the extended grammar 
-                //@return the grammar's first set
-                void create_follow_sets();
-            private:
-                item_set_t create_item_set(const rule_t& kernel);
+                //@return true if those symbols are nullable
+                bool first_of(const std::vector<symbol_t>& rhs, size_t from, dynamic_bitset& set) const;
+
+                //Returns true if merging an LR(1) kernel with the lookaheads lhs into a state with the 
+                //same LR(0) kernel and the lookaheads rhs cannot cause a reduce/reduce conflict that 
+                //neither has on its own (Pager's weak compatibility)
+                static bool weakly_compatible(const std::vector<dynamic_bitset>& lhs, const std::vector<dynamic_bitset>& rhs);
                 void parse_grammar(std::istream& in);
             #ifdef DEBUG
             public: //public for testing ONLY
@@ -192,75 +410,61 @@ namespace final_project
             private:
             #endif
                 std::istream& _M_in;
-                //Set of terminals
-                std::set<std::string> _M_terminals;
-                //All possible input characters
-                std::set<std::string> _M_inputs;
+                lookahead_method_t _M_method;
+                //The names of the grammar symbols
+                symbol_table _M_symbols;
+                //Whether each symbol is a terminal, indexed by symbol
+                std::vector<bool> _M_terminals;
+                //All possible input characters, in order
+                std::vector<symbol_t> _M_inputs;
+                //The goal symbol S, the end of input marker, and the empty string, which 
+                //stands for the right hand side of an epsilon rule. A symbol that does 
+                //not appear in the grammar is NO_SYMBOL.
+                symbol_t _M_start;
+                symbol_t _M_eof;
+                symbol_t _M_epsilon;
                  //List of grammar rules
                 std::vector<rule_t> _M_grammar;
+                //The productions whose start items are in the closure of the start items of 
+                //each nonterminal, indexed by symbol. Empty for terminals. 
+                std::vector<dynamic_bitset> _M_closures;
+                //Whether each symbol of the grammar derives the empty string, indexed by symbol
+                std::vector<bool> _M_symbol_nullable;
+                //The terminals, including $, that each symbol of the grammar starts with, indexed by symbol
+                std::vector<dynamic_bitset> _M_symbol_first;
                 //Translation table
                 translation_table_t _M_translation_table;
-                //Nullable
-                std::unordered_map<extended_rule_t::symbol, bool, symbol_hash> _M_nullable;
-                //First sets 
-                std::unordered_map<extended_rule_t::symbol, std::set<std::string>, symbol_hash> _M_first_sets;
-                //Follow sets
-                std::unordered_map<extended_rule_t::symbol, std::set<std::string>, symbol_hash> _M_follow_sets;
+                //The reductions of each state, in increasing order of production
+                std::vector<std::vector<reduction_t>> _M_reductions;
+                //Nullable, indexed by extended symbol number
+                std::vector<bool> _M_nullable;
+                //First sets, indexed by extended symbol number
+                std::vector<dynamic_bitset> _M_first_sets;
+                //Follow sets, indexed by extended symbol number
+                std::vector<dynamic_bitset> _M_follow_sets;
                 //Extended grammar
                 std::vector<extended_rule_t> _M_extended_grammar;
+                //The symbols of the extended grammar in the order they are numbered
+                std::vector<extended_rule_t::symbol> _M_extended_symbols;
+                //The extended grammar with its symbols replaced by their numbers
+                std::vector<numbered_rule_t> _M_numbered_grammar;
+                //The rule and position of every occurrence of each symbol on a right hand side, 
+                //indexed by symbol number
+                std::vector<std::vector<std::pair<size_t, size_t>>> _M_occurrences;
         };
 
-        inline bool operator<(const parser_generator::rule_t& lhs, const parser_generator::rule_t& other)
-        {
-            if (lhs._M_lhs < other._M_lhs)
-                return true;
-            if (lhs._M_lhs > other._M_lhs)
-                return false;
-            if (lhs._M_rhs.size() < other._M_rhs.size())
-                return true;
-            if (lhs._M_rhs.size() > other._M_rhs.size())
-                return false;
-            for(size_t i = 0; i < lhs._M_rhs.size(); ++i)
-            {
-                if (lhs._M_rhs[i] < other._M_rhs[i])
-                    return true;
-                if (lhs._M_rhs[i] > other._M_rhs[i])
-                    return false;
-            }
-            if (lhs._M_pointer < other._M_pointer)
-                return true;
-            return false;
-        }
-
         inline bool operator==(const parser_generator::rule_t& lhs, const parser_generator::rule_t& other)
         {
-            if(lhs._M_lhs != other._M_lhs)
-                return false;
-            if(!std::equal(lhs._M_rhs.begin(), lhs._M_rhs.end(), other._M_rhs.begin()))
-                return false;
-            return lhs._M_pointer == other._M_pointer;
+            return lhs._M_lhs == other._M_lhs && lhs._M_rhs == other._M_rhs;
         }
 
-        inline bool operator>(const parser_generator::rule_t& lhs, const parser_generator::rule_t& rhs)
-        {
-            return !(lhs < rhs) && !(lhs == rhs);
-        }
-
-
         inline bool operator<(const parser_generator::item_set_t& lhs, const parser_generator::item_set_t& rhs)
         {
-            if(lhs.num_rules() < rhs.num_rules())
+            if(lhs.num_items() < rhs.num_items())
                 return true;
-            if(lhs.num_rules() > rhs.num_rules())
+            if(lhs.num_items() > rhs.num_items())
                 return false;
-            for(auto it1 = lhs._M_rules.begin(), it2 = rhs._M_rules.begin(); it1 != lhs._M_rules.end(); ++it1, ++it2)
-            {
-                if(*it1 < *it2)
-                    return true;
-                if(*it1 > *it2)
-                    return false;
-            }
-            return false;
+            return lhs._M_items < rhs._M_items;
         }
 
     } // namespace parser
@@ -0,0 +1,64 @@
+#ifndef SYMBOL_TABLE_HH
+#define SYMBOL_TABLE_HH 1
+
+#include <string>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <cstdint>
+#include <limits>
+
+namespace final_project
+{
+    namespace parser
+    {
+        //A grammar symbol interned by a symbol_table
+        typedef uint32_t symbol_t;
+
+        //The id returned when a name has not been interned
+        const static symbol_t NO_SYMBOL = std::numeric_limits<symbol_t>::max();
+
+        //Maps the names of grammar symbols to dense integer ids and back, so that 
+        //the parser generator compares and hashes integers instead of strings. 
+        //Names are only looked up when a grammar is read and when tables are written.
+        class symbol_table
+        {
+            public:
+                symbol_table() = default;
+
+                //Interns the specified names in sorted order, so that comparing the 
+                //ids of two symbols gives the same result as comparing their names
+                //
+                //@param first an iterator to the first name 
+                //@param last an iterator past the last name
+                template<class _InputIt>
+                symbol_table(_InputIt first, _InputIt last)
+                    : _M_names(), _M_ids()
+                {
+                    std::set<std::string> names(first, last);
+                    for(const auto& name: names)
+                        intern(name);
+                }
+
+                //Returns the id of the specified name, interning it if it is new
+                //
+                //@param name the name of the symbol
+                //@return the id of the symbol
+                symbol_t intern(const std::string& name);
+
+                //Returns the id of the specified name or NO_SYMBOL if it was never interned
+                symbol_t find(const std::string& name) const;
+
+                //Returns the name of the specified symbol
+                const std::string& name(symbol_t symbol) const;
+
+                //Returns the number of symbols; ids run from 0 to size() - 1
+                size_t size() const;
+            private:
+                std::vector<std::string> _M_names;
+                std::unordered_map<std::string, symbol_t> _M_ids;
+        };
+    } // namespace parser
+} // namespace final_project
+
+#endif
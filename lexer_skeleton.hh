@@ -1,9 +1,17 @@
 #ifndef LEXER_SKELETON_HH
 #define LEXER_SKELETON_HH 1
 
+//Generated options
+
 #include <string>
 #include <vector>
 #include <ostream>
+#include <istream>
+#include <functional>
+#include <cstdint>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 namespace lexer
 {
@@ -13,40 +21,220 @@ namespace lexer
 
     typedef size_t index_t;
 
+    //A token refers to its text by its offset and length in the lexer's input. 
+    //Define LEXER_OWNING_TOKENS to also store a copy of the text in the token. 
+    //Use lexer::position to find the line and column of a token.
     struct token_t
     {
-        index_t _M_line;
-        index_t _M_start_col;
-        index_t _M_end_col;
+        index_t _M_offset;
+        index_t _M_length;
         token_type _M_type;
+    #ifdef LEXER_OWNING_TOKENS
         std::string _M_val;
+    #endif
         token_t() = default;
-        token_t(index_t line, index_t start_col, index_t end_col, token_type type, const std::string& val);
+        token_t(index_t offset, index_t length, token_type type);
+    };
+
+    //A zero-based line and column in the lexer's input
+    struct position_t
+    {
+        index_t _M_line;
+        index_t _M_col;
     };
 
     std::ostream& operator<<(std::ostream& os, const token_t& t); 
 
+    //Describes how lexer::relex changed a token vector: the tokens 
+    //[_M_first, _M_first + _M_removed) were replaced by the _M_inserted tokens 
+    //that now start at _M_first
+    struct splice_t
+    {
+        size_t _M_first;
+        size_t _M_removed;
+        size_t _M_inserted;
+    };
+
     class lexer
     {
         public: 
+            //Reads up to the specified number of characters into the buffer and returns 
+            //the number of characters read; returns 0 at the end of the input
+            typedef std::function<size_t(char*, size_t)> read_callback_t;
+
+            //The number of characters read from a stream at a time
+            static const size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+            //The smallest chunk worth handing to another thread
+            static const index_t MIN_PARALLEL_CHUNK = 1024 * 1024;
+
             explicit lexer(const std::string& text);
 
+            //Lexes the input supplied by the callback. Only the text from the start of 
+            //the current token onwards is kept, so the memory used is bounded by the 
+            //buffer size and the longest token rather than the size of the input. 
+            //
+            //Token offsets are relative to the start of the input. data, text, and view 
+            //may only be used on a token until the next call to next_token.
+            explicit lexer(const read_callback_t& source, size_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+            //Lexes the input read from a stream. The stream must outlive the lexer.
+            explicit lexer(std::istream& in, size_t buffer_size = DEFAULT_BUFFER_SIZE);
+        #if defined(__unix__) || defined(__APPLE__)
+            //Lexes the input read from a file descriptor. The lexer does not close it.
+            explicit lexer(int fd, size_t buffer_size = DEFAULT_BUFFER_SIZE);
+        #endif
+
+            //Lexes a file in place. On POSIX systems the file is mapped read-only 
+            //and tokens point straight into the mapping, so the file is never copied; 
+            //elsewhere the file is read into memory. Throws std::system_error if the 
+            //file cannot be opened or mapped.
+            static lexer from_file(const std::string& path);
+
+            lexer(lexer&& other);
+
+            lexer(const lexer&) = delete;
+
+            lexer& operator=(const lexer&) = delete;
+
+            ~lexer();
+
             token_t next_token();
 
             std::vector<token_t> tokenize(); 
+
+            //Splits the input into chunks and lexes them on the specified number of threads 
+            //(0 uses one per core). Each chunk starts speculatively in the start state right 
+            //after a run of whitespace; the chunks are then stitched together in order, and 
+            //any chunk whose first token does not line up with where the previous chunk ended 
+            //is re-lexed until it does. The result matches tokenize() token for token. 
+            //
+            //No chunk is made smaller than min_chunk characters. Streamed input and lexers 
+            //that already returned tokens are lexed sequentially.
+            std::vector<token_t> tokenize_parallel(size_t threads = 0, index_t min_chunk = MIN_PARALLEL_CHUNK);
+
+            //Replaces the deleted characters starting at offset with the inserted text 
+            //and updates tokens, the result of tokenize() on the input before the edit, 
+            //to match the new input. Lexing restarts in the start state at the end of 
+            //the last token that cannot have changed and stops as soon as a new token 
+            //starts where an old token started after the edit, so the work done is 
+            //proportional to the size of the edit. Tokens after the splice keep their 
+            //types and have their offsets shifted.
+            //
+            //A mapped file is copied into memory the first time it is edited. Throws 
+            //std::logic_error for streamed input and std::out_of_range if the deleted 
+            //characters are not all part of the input.
+            splice_t relex(std::vector<token_t>& tokens, index_t offset, index_t deleted, const std::string& inserted);
+
+            //Lexes up to capacity tokens into the caller's structure-of-arrays buffers and 
+            //returns how many were written; 0 once the input is exhausted. The EOF token 
+            //is not written. base is set to the offset of the first token of the batch and 
+            //offsets[i] is relative to it, so a batch never spans more than 2 GiB of input.
+            //
+            //For streamed input only the offsets and lengths remain meaningful after the call.
+            size_t next_tokens(uint16_t* types, uint32_t* offsets, uint32_t* lengths, size_t capacity, index_t& base);
+
+            //Returns a pointer to the text of a token produced by this lexer
+            const char* data(const token_t& t) const;
+
+            //Returns a copy of the text of a token produced by this lexer
+            std::string text(const token_t& t) const;
+        #if __cplusplus >= 201703L
+            //Returns the text of a token produced by this lexer without copying it
+            std::string_view view(const token_t& t) const
+            {
+                return std::string_view(data(t), t._M_length);
+            }
+        #endif
+
+            //Returns the zero-based line and column of an offset in the input. The lexer 
+            //does not track lines while it lexes; instead the newlines are indexed the 
+            //first time a position past the indexed part of the input is asked for. 
+            //Streamed input is indexed as it is discarded. Not safe to call from 
+            //several threads at once.
+            position_t position(index_t offset) const;
+
+            //Returns the zero-based line and column of the start of a token
+            position_t position(const token_t& t) const
+            {
+                return position(t._M_offset);
+            }
+        #ifdef LEXER_PROFILE
+            //Writes how many times the DFA visited each state and took each transition, 
+            //summed over every lexer in the program, in the format read by the generator's 
+            //--profile option. Only the goto code is instrumented. The counters are not 
+            //synchronized, so profile with tokenize rather than tokenize_parallel.
+            static void write_profile(std::ostream& os);
+        #endif
         private:
+            //The tokens a thread found in its chunk and the first token that starts 
+            //at or after the end of the chunk
+            struct chunk_t
+            {
+                std::vector<token_t> _M_tokens;
+                token_t _M_stop;
+            };
+
+            //Lexes another lexer's in-memory input in place, starting at the specified position
+            lexer(const char* data, index_t length, index_t pos);
+
+            //Lexes the tokens that start in [begin, end)
+            void lex_chunk(index_t begin, index_t end, chunk_t& chunk) const;
+
+            //Moves past the current character. Only called after next_character 
+            //returned a character that is part of the input.
             void advance();
 
-            char next_character() const;
+            //Returns the current character or 0 at the end of the input. Every buffer 
+            //is followed by a NUL sentinel, so the length is only checked when the 
+            //character read is a NUL.
+            char next_character();
+
+            char lookahead();
+
+            //Returns true if there are no characters left at the current position
+            bool at_end();
+
+            //Discards the text before the current token and reads the next chunk of 
+            //the input. Returns false if the input is exhausted.
+            bool refill();
+
+            token_t make_token(token_type type);
 
-            char lookahead() const;
+            //Moves past the character that could not be matched, unless the input has 
+            //ended, and returns an error token
+            token_t error_token();
 
-            token_t make_token(token_type type, const std::string& value);
+            //Records the offsets of the newlines from _M_indexed up to the specified offset
+            void index_newlines(index_t end) const;
         private:
             index_t _M_pos;
-            index_t _M_line;
-            index_t _M_col;
+            index_t _M_start;
+            //The characters being lexed: the whole input, or for streamed input 
+            //the window of it that is still needed. _M_data[_M_length] is always a NUL 
+            //sentinel: std::string storage ends in one, and mapped files are followed 
+            //by a zeroed page.
+            const char* _M_data;
+            index_t _M_length;
+            //Holds the characters of string and streamed input
             std::string _M_text;
+            //The offset of _M_text[0] in the input
+            index_t _M_buffer_offset;
+            //Where the rest of a streamed input comes from; empty once it is exhausted
+            read_callback_t _M_source;
+            size_t _M_buffer_size;
+            //The mapping of a file opened with from_file
+            void* _M_mapping;
+            size_t _M_mapping_length;
+            //The offsets of the newlines before _M_indexed, in order
+            mutable std::vector<index_t> _M_newlines;
+            mutable index_t _M_indexed;
+        #ifdef LEXER_PROFILE
+            //The visits of each state, and the transitions taken from each state 
+            //indexed by state * 256 + character
+            static std::vector<uint64_t> _M_state_hits;
+            static std::vector<uint64_t> _M_transition_hits;
+        #endif
     };
 }
 
@@ -0,0 +1,228 @@
+#include "automata/comb_table.hh"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+
+namespace final_project
+{
+    namespace automata
+    {
+        size_t comb_table::size() const
+        {
+            return _M_base.size() + _M_default.size() + _M_next.size() + _M_check.size();
+        }
+
+        size_t comb_table::dense_size() const
+        {
+            return _M_base.size() * _M_columns;
+        }
+
+        double comb_table::compression_ratio() const
+        {
+            return (size() == 0) ? 1.0 : static_cast<double>(dense_size()) / size();
+        }
+
+        comb_table compress_table(const comb_table::dense_table_t& dense)
+        {
+            //Pick the most common value of each row as its default
+            std::vector<state_t> defaults(dense.size(), 0);
+            for(size_t i = 0; i < dense.size(); ++i)
+            {
+                std::map<state_t, size_t> counts;
+                for(auto value: dense[i])
+                    ++counts[value];
+                auto most_common = std::max_element(counts.begin(), counts.end(),
+                    [](const std::pair<const state_t, size_t>& lhs, const std::pair<const state_t, size_t>& rhs)
+                    {
+                        return lhs.second < rhs.second;
+                    });
+                if (most_common != counts.end())
+                    defaults[i] = most_common->first;
+            }
+            return compress_table(dense, defaults);
+        }
+
+        comb_table compress_table(const comb_table::dense_table_t& dense, const std::vector<state_t>& defaults)
+        {
+            comb_table table;
+            table._M_columns = dense.empty() ? 0 : dense.front().size();
+            table._M_base.assign(dense.size(), 0);
+            table._M_default = defaults;
+
+            //Keep the columns of each row that differ from its default
+            std::vector<std::vector<size_t>> entries(dense.size());
+            for(size_t i = 0; i < dense.size(); ++i)
+            {
+                for(size_t j = 0; j < dense[i].size(); ++j)
+                {
+                    if (dense[i][j] != table._M_default[i])
+                        entries[i].push_back(j);
+                }
+            }
+
+            //Place the densest rows first; they are the hardest to fit
+            std::vector<size_t> order(dense.size());
+            for(size_t i = 0; i < order.size(); ++i)
+                order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs)
+                {
+                    return entries[lhs].size() > entries[rhs].size();
+                });
+
+            //First-fit placement. first_free is the lowest slot that is still empty,
+            //so no row with entries can start below first_free - its first column.
+            size_t first_free = 0;
+            for(auto row: order)
+            {
+                const auto& columns = entries[row];
+                if (columns.empty())
+                    continue;
+                size_t base = (first_free > columns.front()) ? first_free - columns.front() : 0;
+                while(true)
+                {
+                    bool fits = true;
+                    for(auto column: columns)
+                    {
+                        size_t slot = base + column;
+                        if (slot < table._M_check.size() && table._M_check[slot] != -1)
+                        {
+                            fits = false;
+                            break;
+                        }
+                    }
+                    if (fits)
+                        break;
+                    ++base;
+                }
+                size_t needed = base + columns.back() + 1;
+                if (table._M_check.size() < needed)
+                {
+                    table._M_check.resize(needed, -1);
+                    table._M_next.resize(needed, 0);
+                }
+                for(auto column: columns)
+                {
+                    table._M_check[base + column] = static_cast<state_t>(row);
+                    table._M_next[base + column] = dense[row][column];
+                }
+                table._M_base[row] = static_cast<state_t>(base);
+                while(first_free < table._M_check.size() && table._M_check[first_free] != -1)
+                    ++first_free;
+            }
+
+            //Pad so that every column of every row can be looked up without a bounds check
+            size_t max_base = table._M_base.empty() ? 0 : *std::max_element(table._M_base.begin(), table._M_base.end());
+            size_t padded = max_base + table._M_columns;
+            if (table._M_check.size() < padded)
+            {
+                table._M_check.resize(padded, -1);
+                table._M_next.resize(padded, 0);
+            }
+            return table;
+        }
+
+        namespace
+        {
+            //Hashes a row of a dense table
+            struct row_hash
+            {
+                size_t operator()(const std::vector<state_t>& row) const
+                {
+                    size_t hash = 0;
+                    for(auto value: row)
+                        hash ^= static_cast<size_t>(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+                    return hash;
+                }
+            };
+        } // namespace
+
+        std::vector<state_t> merge_identical_rows(comb_table::dense_table_t& dense)
+        {
+            std::unordered_map<std::vector<state_t>, state_t, row_hash> rows;
+            std::vector<state_t> index(dense.size());
+            size_t distinct = 0;
+            for(size_t i = 0; i < dense.size(); ++i)
+            {
+                auto it = rows.find(dense[i]);
+                if (it != rows.end())
+                {
+                    index[i] = it->second;
+                    continue;
+                }
+                index[i] = static_cast<state_t>(distinct);
+                if (distinct != i)
+                    dense[distinct] = std::move(dense[i]);
+                rows.insert(std::make_pair(dense[distinct], index[i]));
+                ++distinct;
+            }
+            dense.resize(distinct);
+            return index;
+        }
+
+        comb_table::dense_table_t make_dense_table(const dfa<char>& d, state_t error)
+        {
+            const auto& transitions = d.get_table();
+            comb_table::dense_table_t dense(transitions.size(), std::vector<state_t>(256, error));
+            for(size_t i = 0; i < transitions.size(); ++i)
+            {
+                for(const auto& transition: transitions[i])
+                {
+                    if (transition.second != ACCEPT)
+                        dense[i][static_cast<unsigned char>(transition.first)] = transition.second;
+                }
+            }
+            return dense;
+        }
+
+        std::string element_type(const comb_table& table)
+        {
+            state_t low = 0;
+            state_t high = 0;
+            const std::vector<state_t>* vectors[] = {&table._M_base, &table._M_default, &table._M_next, &table._M_check};
+            for(auto v: vectors)
+            {
+                for(auto value: *v)
+                {
+                    low = std::min(low, value);
+                    high = std::max(high, value);
+                }
+            }
+            if (low >= std::numeric_limits<signed char>::min() && high <= std::numeric_limits<signed char>::max())
+                return "signed char";
+            if (low >= std::numeric_limits<short>::min() && high <= std::numeric_limits<short>::max())
+                return "short";
+            return "int";
+        }
+
+        //Writes a single vector as a C++ array definition
+        static void print_vector(std::ostream& os, const std::vector<state_t>& v, const std::string& type,
+            const std::string& name, const std::string& indent, const std::string& qualifiers)
+        {
+            os << "\n" << indent << qualifiers << " " << type << " " << name << "[] = {";
+            //Arrays may not be empty
+            if (v.empty())
+                os << "0";
+            for(size_t i = 0; i < v.size(); ++i)
+            {
+                if (i % 16 == 0)
+                    os << "\n" << indent << "     ";
+                os << v[i];
+                if (i + 1 != v.size())
+                    os << ", ";
+            }
+            os << "\n" << indent << "};";
+        }
+
+        void print_comb_table(std::ostream& os, const comb_table& table, const std::string& prefix,
+            const std::string& indent, const std::string& qualifiers)
+        {
+            std::string type = element_type(table);
+            print_vector(os, table._M_base, type, prefix + "_base", indent, qualifiers);
+            print_vector(os, table._M_default, type, prefix + "_default", indent, qualifiers);
+            print_vector(os, table._M_next, type, prefix + "_next", indent, qualifiers);
+            print_vector(os, table._M_check, type, prefix + "_check", indent, qualifiers);
+        }
+    } // namespace automata
+
+} // namespace final_project
@@ -63,9 +63,12 @@ namespace final_project
            {
                 auto q = work_list.front();
                 work_list.pop_front();
-                //Loop over each character in the NFA's alphabet
+                //Loop over each character in the NFA's alphabet. Epsilon moves are 
+                //already part of the closures and do not consume a character.
                 for(auto c: alphabet)
                 {
+                    if (c == EPSILON)
+                        continue;
                     std::set<state_t> t;
                     //Get the states that can be reached from the current state 
                     //upon seeing an input of c 
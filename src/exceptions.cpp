@@ -25,5 +25,16 @@ namespace final_project
     {
         return _M_message.c_str();
     }
+
+    invalid_profile_exception::invalid_profile_exception(const std::string& message)
+        : _M_message(message)
+    {
+
+    }
+
+    const char* invalid_profile_exception::what() const throw() 
+    {
+        return _M_message.c_str();
+    }
     }
 } // namespace final_project::exceptions
@@ -3,22 +3,36 @@
 #include "automata/regex_parser.hh"
 #include "automata/nfa.hh"
 #include "automata/dfa.hh"
+#include "automata/comb_table.hh"
 
 #include <fstream>
 #include <iostream>
+#include <deque>
+#include <map>
+#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <cctype>
 
 namespace final_project
 {
     namespace lexer
     {
+        void print_template_tables(std::ostream& lexer_hh_out, const automata::dfa<char>& table, 
+            const lexer_options& options);
+        void print_self_test(std::ostream& lexer_hh_out, const automata::dfa<char>& table);
+
         //Fills in the lexer_skeleton.hh file with enum types based on the tokens 
-        //the lexer will create. 
+        //the lexer will create. The header only skeleton also gets the DFA tables 
+        //and the compile-time self-test.
         //
         //@param skeleton_hh_in a file stream connected to the lexer skeleton header file
         //@param lexer_hh_out a file stream connected to the lexer header file
+        //@param keywords the keywords that are not part of the DFA
         void generate_hh(std::ifstream& skeleton_hh_in, std::ofstream& lexer_hh_out, 
-            const std::unordered_map<automata::state_t, std::string>& labels)
+            const automata::dfa<char>& table, const keyword_sets_t& keywords, const lexer_options& options)
         {
+            const auto& labels = table.get_accepting_labels();
             std::string line;
             std::set<std::string> tokens;
             std::transform(labels.begin(), labels.end(), std::inserter(tokens, tokens.end()), 
@@ -26,14 +40,31 @@ namespace final_project
                 {
                     return p.second;
                 });
+            for(const auto& keyword_set: keywords)
+                tokens.insert(keyword_set.second.begin(), keyword_set.second.end());
             bool in_enum = false;
             while(getline(skeleton_hh_in, line))
             {
                 //Remove skeleton in include guards
                 if (line.find("SKELETON") != line.npos)
                 {
-                    line.erase(14, 9);
+                    line.erase(line.find("SKELETON_"), 9);
+                    lexer_hh_out << line << "\n";
+                }
+                else if (line.find("Generated tables") != line.npos)
+                {
+                    print_template_tables(lexer_hh_out, table, options);
+                }
+                else if (line.find("Generated self-test") != line.npos)
+                {
+                    print_self_test(lexer_hh_out, table);
+                }
+                //Write the macros for the selected options
+                else if (line.find("Generated options") != line.npos)
+                {
                     lexer_hh_out << line << "\n";
+                    if (options._M_owning_tokens)
+                        lexer_hh_out << "#define LEXER_OWNING_TOKENS 1\n";
                 }
                 //Create enum
                 //Found enum declaration
@@ -64,93 +95,608 @@ namespace final_project
             }
         }
 
+        //Generate code that skips the whitespace in front of the next token and marks where 
+        //the token starts. Tokens are returned as an offset and a length into the input, so 
+        //nothing is copied while the DFA runs.
+        void print_token_start(std::ostream& lexer_cpp_out)
+        {
+            lexer_cpp_out << "     _M_start = _M_pos;";
+            lexer_cpp_out << "\n     while(isspace(next_character()))";
+            lexer_cpp_out << "\n     {";
+            lexer_cpp_out << "\n          advance();";
+            lexer_cpp_out << "\n          _M_start = _M_pos;";
+            lexer_cpp_out << "\n     }";
+            lexer_cpp_out << "\n     if(at_end())";
+            lexer_cpp_out << "\n          return make_token(token_type::tl_EOF);";
+        }
+
+        //The most ranges of characters a self-loop may be made of and still be 
+        //tested with vector compares
+        static const size_t MAX_SELF_LOOP_RANGES = 4;
+
+        //Finds the characters on which the specified state transitions back to itself 
+        //and returns them as a sorted list of inclusive ranges. Whitespace is left out 
+        //because the generated code ends the token on whitespace before it looks at 
+        //the transitions.
+        std::vector<std::pair<unsigned char, unsigned char>> self_loop_ranges(const automata::dfa<char>& table, size_t state)
+        {
+            std::vector<bool> loops(256, false);
+            for(const auto& transition: table.get_table()[state])
+            {
+                unsigned char c = static_cast<unsigned char>(transition.first);
+                if (transition.second == static_cast<automata::state_t>(state) && c != 0 && !isspace(c))
+                    loops[c] = true;
+            }
+            std::vector<std::pair<unsigned char, unsigned char>> ranges;
+            for(int c = 0; c < 256; ++c)
+            {
+                if (!loops[c])
+                    continue;
+                int end = c;
+                while(end + 1 < 256 && loops[end + 1])
+                    ++end;
+                ranges.push_back(std::make_pair(static_cast<unsigned char>(c), static_cast<unsigned char>(end)));
+                c = end;
+            }
+            return ranges;
+        }
+
+        //Generate a vectorized loop that consumes the longest run of characters that keep the 
+        //DFA in the current state, 32 (AVX2) or 16 (SSE2) characters at a time. The scalar goto 
+        //code that follows handles the rest of the run and is the fallback when neither 
+        //instruction set is available.
+        void print_self_loop_skip(std::ostream& lexer_cpp_out, const std::vector<std::pair<unsigned char, unsigned char>>& ranges)
+        {
+            const char* prefixes[] = {"_mm256", "_mm"};
+            const char* vector_types[] = {"__m256i", "__m128i"};
+            const char* guards[] = {"#if defined(__AVX2__)", "#elif defined(__SSE2__)"};
+            const char* widths[] = {"32", "16"};
+            const char* full_masks[] = {"0xFFFFFFFFu", "0xFFFFu"};
+            for(int v = 0; v < 2; ++v)
+            {
+                std::string prefix = prefixes[v];
+                std::string type = vector_types[v];
+                std::string si = (v == 0) ? "si256" : "si128";
+                lexer_cpp_out << "\n" << guards[v];
+                lexer_cpp_out << "\n          {";
+                lexer_cpp_out << "\n               const char* start = _M_data + _M_pos;";
+                lexer_cpp_out << "\n               const char* p = start;";
+                lexer_cpp_out << "\n               const char* end = _M_data + _M_length;";
+                lexer_cpp_out << "\n               while(end - p >= " << widths[v] << ")";
+                lexer_cpp_out << "\n               {";
+                lexer_cpp_out << "\n                    " << type << " x = " << prefix << "_loadu_" << si 
+                    << "(reinterpret_cast<const " << type << "*>(p));";
+                lexer_cpp_out << "\n                    " << type << " in = " << prefix << "_setzero_" << si << "();";
+                for(const auto& range: ranges)
+                {
+                    if (range.first == range.second)
+                    {
+                        lexer_cpp_out << "\n                    in = " << prefix << "_or_" << si << "(in, " << prefix 
+                            << "_cmpeq_epi8(x, " << prefix << "_set1_epi8(static_cast<char>(" << static_cast<int>(range.first) << "))));";
+                    }
+                    else
+                    {
+                        //x is in [lo, hi] if (x - lo) <= (hi - lo) as unsigned bytes
+                        lexer_cpp_out << "\n                    {";
+                        lexer_cpp_out << "\n                         " << type << " t = " << prefix << "_sub_epi8(x, " << prefix 
+                            << "_set1_epi8(static_cast<char>(" << static_cast<int>(range.first) << ")));";
+                        lexer_cpp_out << "\n                         in = " << prefix << "_or_" << si << "(in, " << prefix << "_cmpeq_epi8(" 
+                            << prefix << "_min_epu8(t, " << prefix << "_set1_epi8(static_cast<char>(" 
+                            << static_cast<int>(range.second - range.first) << "))), t));";
+                        lexer_cpp_out << "\n                    }";
+                    }
+                }
+                lexer_cpp_out << "\n                    unsigned mask = ~static_cast<unsigned>(" << prefix << "_movemask_epi8(in)) & " 
+                    << full_masks[v] << ";";
+                lexer_cpp_out << "\n                    if(mask)";
+                lexer_cpp_out << "\n                    {";
+                lexer_cpp_out << "\n                         p += lowest_set_bit(mask);";
+                lexer_cpp_out << "\n                         break;";
+                lexer_cpp_out << "\n                    }";
+                lexer_cpp_out << "\n                    p += " << widths[v] << ";";
+                lexer_cpp_out << "\n               }";
+                lexer_cpp_out << "\n               _M_pos += p - start;";
+                lexer_cpp_out << "\n          }";
+            }
+            lexer_cpp_out << "\n#endif";
+        }
+
+        //The hash of a keyword with the specified seed. Must compute the same values as 
+        //the tl_hash function emitted by print_keyword_lookup.
+        uint32_t keyword_hash(const std::string& keyword, uint32_t seed)
+        {
+            uint32_t h = 2166136261u ^ seed;
+            for(auto c: keyword)
+            {
+                h ^= static_cast<unsigned char>(c);
+                h *= 16777619u;
+            }
+            return h;
+        }
+
+        //A minimal perfect hash of a set of keywords, found by hash and displace. The 
+        //keywords are split into buckets by their hash with seed 0. Starting with the 
+        //largest bucket, each bucket gets the first seed that sends all of its keywords 
+        //to free slots, so a keyword's slot is 
+        //    keyword_hash(keyword, seeds[keyword_hash(keyword, 0) % buckets]) % keywords
+        struct keyword_table
+        {
+            std::vector<uint32_t> _M_seeds;
+            //The keyword in each slot
+            std::vector<std::string> _M_slots;
+        };
+
+        keyword_table make_keyword_table(const std::vector<std::string>& keywords)
+        {
+            size_t n = keywords.size();
+            std::vector<std::vector<std::string>> buckets(n);
+            for(const auto& keyword: keywords)
+                buckets[keyword_hash(keyword, 0) % n].push_back(keyword);
+            std::vector<size_t> order(n);
+            for(size_t i = 0; i < n; ++i)
+                order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&buckets](size_t a, size_t b)
+                {
+                    return buckets[a].size() > buckets[b].size();
+                });
+            keyword_table table;
+            table._M_seeds.assign(n, 0);
+            table._M_slots.assign(n, std::string());
+            std::vector<bool> used(n, false);
+            std::vector<size_t> slots;
+            for(size_t bucket: order)
+            {
+                if (buckets[bucket].empty())
+                    break;
+                for(uint32_t seed = 1; ; ++seed)
+                {
+                    if (seed == 0)
+                        throw exceptions::invalid_regex_exception("Could not find a perfect hash for the keywords");
+                    slots.clear();
+                    for(const auto& keyword: buckets[bucket])
+                    {
+                        size_t slot = keyword_hash(keyword, seed) % n;
+                        if (used[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end())
+                            break;
+                        slots.push_back(slot);
+                    }
+                    if (slots.size() != buckets[bucket].size())
+                        continue;
+                    table._M_seeds[bucket] = seed;
+                    for(size_t i = 0; i < slots.size(); ++i)
+                    {
+                        used[slots[i]] = true;
+                        table._M_slots[slots[i]] = buckets[bucket][i];
+                    }
+                    break;
+                }
+            }
+            return table;
+        }
+
+        //Generate a function for every keyword set that returns the type of a token 
+        //matched by the set's rule: the keyword its text is equal to, found with a 
+        //perfect hash and one memcmp, or the rule itself. tl_keyword does the same for 
+        //a token of any type.
+        void print_keyword_lookup(std::ostream& lexer_cpp_out, const keyword_sets_t& keywords)
+        {
+            lexer_cpp_out << "    //FNV-1a hash of a token's text, used to look up keywords";
+            lexer_cpp_out << "\n    static inline uint32_t tl_hash(const char* s, size_t n, uint32_t seed)";
+            lexer_cpp_out << "\n    {";
+            lexer_cpp_out << "\n         uint32_t h = 2166136261u ^ seed;";
+            lexer_cpp_out << "\n         for(size_t i = 0; i < n; ++i)";
+            lexer_cpp_out << "\n         {";
+            lexer_cpp_out << "\n              h ^= static_cast<unsigned char>(s[i]);";
+            lexer_cpp_out << "\n              h *= 16777619u;";
+            lexer_cpp_out << "\n         }";
+            lexer_cpp_out << "\n         return h;";
+            lexer_cpp_out << "\n    }\n";
+            for(const auto& keyword_set: keywords)
+            {
+                const std::string& rule = keyword_set.first;
+                keyword_table table = make_keyword_table(keyword_set.second);
+                size_t n = table._M_slots.size();
+                size_t min_length = table._M_slots[0].length(), max_length = 0;
+                for(const auto& keyword: table._M_slots)
+                {
+                    min_length = std::min(min_length, keyword.length());
+                    max_length = std::max(max_length, keyword.length());
+                }
+                lexer_cpp_out << "\n    static const uint32_t tl_" << rule << "_seeds[] = {";
+                for(size_t i = 0; i < n; ++i)
+                    lexer_cpp_out << (i % 16 == 0 ? "\n         " : " ") << table._M_seeds[i] << ",";
+                lexer_cpp_out << "\n    };";
+                lexer_cpp_out << "\n    static const char* const tl_" << rule << "_keywords[] = {";
+                for(const auto& keyword: table._M_slots)
+                    lexer_cpp_out << "\n         \"" << keyword << "\",";
+                lexer_cpp_out << "\n    };";
+                lexer_cpp_out << "\n    static const unsigned char tl_" << rule << "_lengths[] = {";
+                for(size_t i = 0; i < n; ++i)
+                    lexer_cpp_out << (i % 16 == 0 ? "\n         " : " ") << table._M_slots[i].length() << ",";
+                lexer_cpp_out << "\n    };";
+                lexer_cpp_out << "\n    static const token_type tl_" << rule << "_types[] = {";
+                for(const auto& keyword: table._M_slots)
+                    lexer_cpp_out << "\n         token_type::tl_" << keyword << ",";
+                lexer_cpp_out << "\n    };\n";
+                lexer_cpp_out << "\n    static inline token_type tl_keyword_" << rule << "(const char* s, size_t n)";
+                lexer_cpp_out << "\n    {";
+                lexer_cpp_out << "\n         if(n < " << min_length << " || n > " << max_length << ")";
+                lexer_cpp_out << "\n              return token_type::tl_" << rule << ";";
+                lexer_cpp_out << "\n         uint32_t slot = tl_hash(s, n, tl_" << rule << "_seeds[tl_hash(s, n, 0) % " << n << "]) % " << n << ";";
+                lexer_cpp_out << "\n         if(n == tl_" << rule << "_lengths[slot] && std::memcmp(s, tl_" << rule << "_keywords[slot], n) == 0)";
+                lexer_cpp_out << "\n              return tl_" << rule << "_types[slot];";
+                lexer_cpp_out << "\n         return token_type::tl_" << rule << ";";
+                lexer_cpp_out << "\n    }\n";
+            }
+            lexer_cpp_out << "\n    static inline token_type tl_keyword(token_type type, const char* s, size_t n)";
+            lexer_cpp_out << "\n    {";
+            for(const auto& keyword_set: keywords)
+            {
+                lexer_cpp_out << "\n         if(type == token_type::tl_" << keyword_set.first << ")";
+                lexer_cpp_out << "\n              return tl_keyword_" << keyword_set.first << "(s, n);";
+            }
+            lexer_cpp_out << "\n         return type;";
+            lexer_cpp_out << "\n    }\n\n";
+        }
+
+        //Returns the expression for the type of a token of the specified rule that ends 
+        //at the current position: the rule itself, or for a rule with keywords the 
+        //keyword the token's text is equal to
+        std::string token_type_expression(const std::string& rule, const keyword_sets_t& keywords)
+        {
+            if (keywords.find(rule) == keywords.end())
+                return "token_type::tl_" + rule;
+            return "tl_keyword_" + rule + "(_M_data + _M_start, _M_pos - _M_start)";
+        }
+
+        //How often an instrumented lexer visited each DFA state and took each transition, 
+        //as written by lexer::write_profile. Both vectors are empty without a profile.
+        struct lexer_profile
+        {
+            std::vector<uint64_t> _M_states;
+            //Indexed by state * 256 + character
+            std::vector<uint64_t> _M_transitions;
+        };
+
+        //Reads a profile written by an instrumented lexer and checks that it was recorded 
+        //with the specified DFA
+        lexer_profile read_profile(const std::string& filename, const automata::dfa<char>& table)
+        {
+            std::ifstream fin(filename.c_str());
+            if(!fin.is_open())
+                throw exceptions::file_not_found_exception("Could not open profile " + filename);
+            const auto& transitions = table.get_table();
+            std::string kind;
+            size_t num_states;
+            if (!(fin >> kind >> num_states) || kind != "states" || num_states != transitions.size())
+                throw exceptions::invalid_profile_exception("The profile " + filename + " was not recorded with this lexer");
+            lexer_profile profile;
+            profile._M_states.assign(num_states, 0);
+            profile._M_transitions.assign(num_states * 256, 0);
+            size_t state;
+            while(fin >> kind >> state)
+            {
+                int c = 0;
+                uint64_t count;
+                if (kind == "t" && !(fin >> c))
+                    break;
+                if (!(fin >> count) || (kind != "s" && kind != "t") || state >= num_states || c < 0 || c > 255)
+                    throw exceptions::invalid_profile_exception("The profile " + filename + " is malformed");
+                if (kind == "s")
+                {
+                    profile._M_states[state] = count;
+                    continue;
+                }
+                auto transition = transitions[state].find(static_cast<char>(c));
+                if (transition == transitions[state].end() || transition->second == automata::ACCEPT)
+                    throw exceptions::invalid_profile_exception("The profile " + filename + " was not recorded with this lexer");
+                profile._M_transitions[state * 256 + c] = count;
+            }
+            if (!fin.eof())
+                throw exceptions::invalid_profile_exception("The profile " + filename + " is malformed");
+            return profile;
+        }
+
+        //Generate the counters of the instrumented build. With LEXER_PROFILE defined 
+        //TL_VISIT counts a visit to a state and TL_TAKE a transition out of it; otherwise 
+        //both expand to nothing.
+        void print_profile_macros(std::ostream& lexer_cpp_out, size_t num_states)
+        {
+            lexer_cpp_out << "\n#ifdef LEXER_PROFILE";
+            lexer_cpp_out << "\n     if(_M_state_hits.empty())";
+            lexer_cpp_out << "\n     {";
+            lexer_cpp_out << "\n          _M_state_hits.assign(" << num_states << ", 0);";
+            lexer_cpp_out << "\n          _M_transition_hits.assign(" << num_states * 256 << ", 0);";
+            lexer_cpp_out << "\n     }";
+            lexer_cpp_out << "\n#define TL_VISIT(state) ++_M_state_hits[state]";
+            lexer_cpp_out << "\n#define TL_TAKE(state, c) ++_M_transition_hits[(state) * 256 + static_cast<unsigned char>(c)]";
+            lexer_cpp_out << "\n#else";
+            lexer_cpp_out << "\n#define TL_VISIT(state)";
+            lexer_cpp_out << "\n#define TL_TAKE(state, c)";
+            lexer_cpp_out << "\n#endif";
+        }
+
         //Generate code to represent DFA table. Converts the DFA table into goto statements 
         //in the code.
-        void print_dfa_table(std::ostream& lexer_cpp_out, const automata::dfa<char>& table)
+        //
+        //The transitions of a state are tested in order of character, or with a profile 
+        //from the most to the least taken. A profile also orders the states from the most 
+        //to the least visited, after the start state, and sends every error to a single 
+        //block at the end so the hot code stays together.
+        void print_dfa_table(std::ostream& lexer_cpp_out, const automata::dfa<char>& table, const keyword_sets_t& keywords,
+            const lexer_options& options, const lexer_profile& profile)
         {
             std::unordered_map<automata::state_t, std::string> accepting_labels = table.get_accepting_labels();
             const auto& transitions = table.get_table();
             const auto& accepting_states = table.get_accepting_states();
-            for(size_t i = 0; i < transitions.size(); ++i)
+            bool profiled = !profile._M_states.empty();
+            std::string error_action = profiled ? "goto tl_error;" : "return error_token();";
+            print_profile_macros(lexer_cpp_out, transitions.size());
+            //Only the states some transition goes to get a label; the code after the 
+            //token start falls into the start state, so it comes first
+            std::vector<bool> targeted(transitions.size(), false);
+            for(const auto& row: transitions)
+            {
+                for(const auto& transition: row)
+                {
+                    if(transition.second != automata::ACCEPT && transition.first != automata::EPSILON)
+                        targeted[transition.second] = true;
+                }
+            }
+            std::vector<size_t> order(transitions.size());
+            for(size_t i = 0; i < order.size(); ++i)
+                order[i] = i;
+            if (profiled)
+            {
+                std::stable_sort(order.begin() + 1, order.end(), [&profile](size_t a, size_t b)
+                    {
+                        return profile._M_states[a] > profile._M_states[b];
+                    });
+            }
+            for(size_t i: order)
             {
                 //Print state name
-                lexer_cpp_out << "\n     tl" << i << ":";
+                if (targeted[i])
+                    lexer_cpp_out << "\n     tl" << i << ":";
                 lexer_cpp_out << "\n     {";
-                lexer_cpp_out << "\n          char c = next_character();";
-                if (i == 0)
+                lexer_cpp_out << "\n          TL_VISIT(" << i << ");";
+                if (i != 0 && options._M_simd_self_loops)
                 {
-                    lexer_cpp_out << "    if(isspace(c))";
-                    lexer_cpp_out << "\n  {";
-                    lexer_cpp_out << "\n        advance();";
-                    lexer_cpp_out << "\n        goto tl0;";
-                    lexer_cpp_out << "\n   }";
+                    //The vectorized loop would take self-loops without counting them
+                    auto ranges = self_loop_ranges(table, i);
+                    if (!ranges.empty() && ranges.size() <= MAX_SELF_LOOP_RANGES)
+                    {
+                        lexer_cpp_out << "\n#ifndef LEXER_PROFILE";
+                        print_self_loop_skip(lexer_cpp_out, ranges);
+                        lexer_cpp_out << "\n#endif";
+                    }
                 }
+                lexer_cpp_out << "\n          char c = next_character();";
                 //Check if we have seen a space that endicates the end of this token 
                 //If so, we need to either make a token instaed of looking for more characters
-                else if (std::find(accepting_states.begin(), accepting_states.end(), static_cast<automata::state_t>(i)) != accepting_states.end())
+                if (std::find(accepting_states.begin(), accepting_states.end(), static_cast<automata::state_t>(i)) != accepting_states.end())
                 {
-                    lexer_cpp_out << "\n            if(isspace(c))";
-                    lexer_cpp_out << "\n                  return make_token(token_type::tl_" << accepting_labels.find(i)->second << ", value);";
+                    lexer_cpp_out << "\n          if(isspace(c))";
+                    lexer_cpp_out << "\n               return make_token(" << token_type_expression(accepting_labels.find(i)->second, keywords) << ");";
                 }
                 else
                 {
                     lexer_cpp_out << "\n          if(isspace(c))";
-                    lexer_cpp_out << "\n           {";
-                    lexer_cpp_out << "\n                   value += c;";
-                    lexer_cpp_out << "\n                   advance();";
-                    lexer_cpp_out << "\n                   return make_token(token_type::tl_ERROR , value);";
-                    lexer_cpp_out << "\n           }";
-                }
-                //Get transition transitions form current character
-                const auto& row = transitions[i];
-                //Print goto statements for transition
-                for(auto it = row.begin(); it != row.end(); ++it)
+                    lexer_cpp_out << "\n               " << error_action;
+                }
+                //Get transition transitions form current character. EPSILON and ACCEPT 
+                //are handled below.
+                std::vector<std::pair<char, automata::state_t>> row;
+                for(const auto& transition: transitions[i])
                 {
-                    if(it->second == automata::ACCEPT) //Handled below
-                        continue;
-                    if (it == row.begin())
+                    if(transition.second != automata::ACCEPT && transition.first != automata::EPSILON)
+                        row.push_back(transition);
+                }
+                auto hits = [&profile, i](char c) -> uint64_t
                     {
-                        if (it->first == automata::EPSILON)
-                            lexer_cpp_out << "\n         if(!c)";
-                        else
-                            lexer_cpp_out << "\n         if(c == '" << (it->first == '\\' ? "\\" : "" ) << it->first << "')";
-                    }
-                    else
+                        return profile._M_transitions.empty() ? 0 : profile._M_transitions[i * 256 + static_cast<unsigned char>(c)];
+                    };
+                std::sort(row.begin(), row.end(), [&hits](const std::pair<char, automata::state_t>& a, 
+                        const std::pair<char, automata::state_t>& b)
                     {
-                       if (it->first == automata::EPSILON)
-                            lexer_cpp_out << "\n         else if(!c)";
-                        else
-                            lexer_cpp_out << "\n         else if(c == '" << (it->first == '\\' ? "\\" : "" ) << it->first << "')";
-                    }
-                    lexer_cpp_out << "\n             {";
-                    lexer_cpp_out << "\n                  value += c;";
-                    lexer_cpp_out << "\n                  advance();";
-                    lexer_cpp_out << "\n                  goto tl" << it->second << ";";      
-                    lexer_cpp_out << "\n             }";                        
+                        if (hits(a.first) != hits(b.first))
+                            return hits(a.first) > hits(b.first);
+                        return static_cast<unsigned char>(a.first) < static_cast<unsigned char>(b.first);
+                    });
+                //Print goto statements for transition. There is never a transition on 
+                //NUL, so the sentinel after the input falls through to the end of the token.
+                bool first = true;
+                for(auto it = row.begin(); it != row.end(); ++it)
+                {
+                    lexer_cpp_out << "\n          " << (first ? "" : "else ") << "if(c == '" 
+                        << (it->first == '\\' ? "\\" : "" ) << it->first << "')";
+                    first = false;
+                    lexer_cpp_out << "\n          {";
+                    lexer_cpp_out << "\n               TL_TAKE(" << i << ", c);";
+                    lexer_cpp_out << "\n               advance();";
+                    lexer_cpp_out << "\n               goto tl" << it->second << ";";      
+                    lexer_cpp_out << "\n          }";                        
                 }
                  //Print accept action
                 if (std::find(accepting_states.begin(), accepting_states.end(), static_cast<automata::state_t>(i)) != accepting_states.end())
                 {
-                    if(row.size() > 1)
-                        lexer_cpp_out << "\n            else";
-                    lexer_cpp_out << "\n                  return make_token(token_type::tl_" << accepting_labels.find(i)->second << ", value);";
+                    if(!first)
+                        lexer_cpp_out << "\n          else";
+                    lexer_cpp_out << "\n" << (first ? "          " : "               ") 
+                        << "return make_token(" << token_type_expression(accepting_labels.find(i)->second, keywords) << ");";
                 }
                 else
                 {
-                    lexer_cpp_out << "\n           else";
-                    lexer_cpp_out << "\n           {";
-                    lexer_cpp_out << "\n                   value += c;";
-                    lexer_cpp_out << "\n                   advance();";
-                    lexer_cpp_out << "\n                   return make_token(token_type::tl_ERROR , value);";
-                    lexer_cpp_out << "\n           }";
+                    if(!first)
+                        lexer_cpp_out << "\n          else";
+                    lexer_cpp_out << "\n" << (first ? "          " : "               ") << error_action;
                 }
                 lexer_cpp_out << "\n     }";
             } 
-            lexer_cpp_out << "\n     return make_token(token_type::tl_ERROR, value);";
+            if (profiled)
+            {
+                lexer_cpp_out << "\n     tl_error:";
+                lexer_cpp_out << "\n          return error_token();";
+            }
+        }
+
+        //Generate the tl_accept array holding the token produced in each state, 
+        //tl_ERROR if the state is not accepting
+        void print_accept_table(std::ostream& lexer_out, const automata::dfa<char>& table, 
+            const std::string& qualifiers, const std::string& indent)
+        {
+            const auto& accepting_labels = table.get_accepting_labels();
+            const auto& accepting_states = table.get_accepting_states();
+            lexer_out << "\n" << indent << qualifiers << " token_type tl_accept[] = {";
+            for(size_t i = 0; i < table.get_table().size(); ++i)
+            {
+                lexer_out << "\n" << indent << "     ";
+                auto it = accepting_labels.find(static_cast<automata::state_t>(i));
+                if (it != accepting_labels.end() && std::find(accepting_states.begin(), accepting_states.end(), 
+                        static_cast<automata::state_t>(i)) != accepting_states.end())
+                    lexer_out << "token_type::tl_" << it->second;
+                else
+                    lexer_out << "token_type::tl_ERROR";
+                lexer_out << ",";
+            }
+            lexer_out << "\n" << indent << "};";
+        }
+
+        //Generate code to represent the DFA as row displacement compressed tables. The 
+        //tables are walked by a loop that behaves exactly like the goto statements 
+        //emitted by print_dfa_table.
+        void print_compressed_dfa_table(std::ostream& lexer_cpp_out, const automata::comb_table& compressed, 
+            const automata::dfa<char>& table, const keyword_sets_t& keywords)
+        {
+            std::string type = keywords.empty() ? "tl_accept[state]" : "tl_keyword(tl_accept[state], _M_data + _M_start, _M_pos - _M_start)";
+            automata::print_comb_table(lexer_cpp_out, compressed, "tl", "     ");
+            print_accept_table(lexer_cpp_out, table, "static const", "     ");
+            lexer_cpp_out << "\n     int state = 0;";
+            lexer_cpp_out << "\n     while(true)";
+            lexer_cpp_out << "\n     {";
+            lexer_cpp_out << "\n          char c = next_character();";
+            //Whitespace ends the token before any transition is taken, like in the goto code
+            lexer_cpp_out << "\n          if(isspace(c))";
+            lexer_cpp_out << "\n               return tl_accept[state] != token_type::tl_ERROR ? make_token(" << type << ") : error_token();";
+            lexer_cpp_out << "\n          size_t i = tl_base[state] + static_cast<unsigned char>(c);";
+            lexer_cpp_out << "\n          int next = (tl_check[i] == state) ? tl_next[i] : tl_default[state];";
+            lexer_cpp_out << "\n          if(next >= 0)";
+            lexer_cpp_out << "\n          {";
+            lexer_cpp_out << "\n               advance();";
+            lexer_cpp_out << "\n               state = next;";
+            lexer_cpp_out << "\n               continue;";
+            lexer_cpp_out << "\n          }";
+            lexer_cpp_out << "\n          if(tl_accept[state] != token_type::tl_ERROR)";
+            lexer_cpp_out << "\n               return make_token(" << type << ");";
+            lexer_cpp_out << "\n          return error_token();";
+            lexer_cpp_out << "\n     }";
+        }
+
+        //Prints the size of the compressed DFA table compared to a dense table
+        void print_compression_report(const automata::comb_table& compressed)
+        {
+            std::cout << "Lexer DFA table: " << compressed.dense_size() << " entries uncompressed, " 
+                << compressed.size() << " entries compressed (ratio " << compressed.compression_ratio() << ")" << std::endl;
+        }
+
+        //Generate the DFA as constexpr compressed tables for the header only lexer. The 
+        //arrays are members of a class template so that they can be defined in the header 
+        //without violating the one definition rule.
+        void print_template_tables(std::ostream& lexer_hh_out, const automata::dfa<char>& table, 
+            const lexer_options& options)
+        {
+            automata::comb_table compressed = automata::compress_table(automata::make_dense_table(table, -1));
+            if (options._M_report_compression)
+                print_compression_report(compressed);
+            std::string type = automata::element_type(compressed);
+            lexer_hh_out << "    template<class _Tp = void>";
+            lexer_hh_out << "\n    struct basic_tables";
+            lexer_hh_out << "\n    {";
+            automata::print_comb_table(lexer_hh_out, compressed, "tl", "        ", "static constexpr");
+            print_accept_table(lexer_hh_out, table, "static constexpr", "        ");
+            lexer_hh_out << "\n    };\n";
+            const char* names[] = {"tl_base", "tl_default", "tl_next", "tl_check"};
+            for(auto name: names)
+                lexer_hh_out << "\n    template<class _Tp> constexpr " << type << " basic_tables<_Tp>::" << name << "[];";
+            lexer_hh_out << "\n    template<class _Tp> constexpr token_type basic_tables<_Tp>::tl_accept[];\n";
+            lexer_hh_out << "\n    typedef basic_tables<> tables;";
+            lexer_hh_out << "\n    typedef basic_lexer<tables> lexer;\n";
         }
 
-        void generate_lexer_cpp(std::ifstream& skeleton_cpp_in, std::ofstream& lexer_cpp_out, const automata::dfa<char>& table)
+        //Finds a shortest input that takes the DFA from its start state to an accepting 
+        //state of each token type. Only printable characters other than whitespace are 
+        //used, so the inputs can be written as string literals.
+        //
+        //@param table the DFA of the lexer
+        //@return the sample input of each token type that has one
+        std::map<std::string, std::string> sample_tokens(const automata::dfa<char>& table)
         {
+            const auto& transitions = table.get_table();
+            const auto& accepting_labels = table.get_accepting_labels();
+            const auto& accepting_states = table.get_accepting_states();
+            std::map<std::string, std::string> samples;
+            std::vector<std::string> inputs(transitions.size());
+            std::vector<bool> visited(transitions.size(), false);
+            std::deque<automata::state_t> work_list = {0};
+            visited[0] = true;
+            while(!work_list.empty())
+            {
+                automata::state_t state = work_list.front();
+                work_list.pop_front();
+                auto label = accepting_labels.find(state);
+                if (state != 0 && label != accepting_labels.end() && samples.find(label->second) == samples.end() && 
+                        std::find(accepting_states.begin(), accepting_states.end(), state) != accepting_states.end())
+                    samples[label->second] = inputs[state];
+                //Visit the characters in order so the samples do not depend on hashing
+                std::map<char, automata::state_t> row;
+                for(const auto& transition: transitions[state])
+                {
+                    if (transition.second != automata::ACCEPT && isgraph(static_cast<unsigned char>(transition.first)))
+                        row.insert(transition);
+                }
+                for(const auto& transition: row)
+                {
+                    if (visited[transition.second])
+                        continue;
+                    visited[transition.second] = true;
+                    inputs[transition.second] = inputs[state] + transition.first;
+                    work_list.push_back(transition.second);
+                }
+            }
+            return samples;
+        }
+
+        //Generate static_assert checks that a sample input of every token type lexes as 
+        //that token at compile time
+        void print_self_test(std::ostream& lexer_hh_out, const automata::dfa<char>& table)
+        {
+            lexer_hh_out << "//Compile-time self-test: a shortest input of every token type must lex as that token";
+            for(const auto& sample: sample_tokens(table))
+            {
+                std::string literal;
+                for(auto c: sample.second)
+                {
+                    if (c == '\\' || c == '"' || c == '?')
+                        literal += '\\';
+                    literal += c;
+                }
+                lexer_hh_out << "\nstatic_assert(lexer::lexer::matches(\"" << literal << "\", lexer::token_type::tl_" 
+                    << sample.first << "), \"the lexer tables do not match " << sample.first << "\");";
+            }
+            lexer_hh_out << "\n";
+        }
+
+        void generate_lexer_cpp(std::ifstream& skeleton_cpp_in, std::ofstream& lexer_cpp_out, const automata::dfa<char>& table,
+            const keyword_sets_t& keywords, const lexer_options& options)
+        {
+            lexer_profile profile;
+            if (!options._M_profile.empty() && !options._M_compress_tables)
+                profile = read_profile(options._M_profile, table);
+            automata::comb_table compressed;
+            if (options._M_compress_tables || options._M_report_compression)
+                compressed = automata::compress_table(automata::make_dense_table(table, -1));
+            if (options._M_report_compression)
+                print_compression_report(compressed);
             std::string line;
             bool in_next_token = false;
             while(getline(skeleton_cpp_in, line))
@@ -160,8 +706,10 @@ namespace final_project
                     lexer_cpp_out << "#include \"lexer.hh\"" << "\n";
                     continue;
                 }
-                if (line.find("lexer::next_token") != std::string::npos)
+                if (line.find("token_t lexer::next_token()") != std::string::npos)
                 {
+                    if (!keywords.empty())
+                        print_keyword_lookup(lexer_cpp_out, keywords);
                     in_next_token = true;
                     lexer_cpp_out << line << "\n";
                 }
@@ -173,8 +721,11 @@ namespace final_project
                 }
                 else if (in_next_token)
                 {
-                    lexer_cpp_out << "     std::string value = \"\";";
-                    print_dfa_table(lexer_cpp_out, table);
+                    print_token_start(lexer_cpp_out);
+                    if (options._M_compress_tables)
+                        print_compressed_dfa_table(lexer_cpp_out, compressed, table, keywords);
+                    else
+                        print_dfa_table(lexer_cpp_out, table, keywords, options, profile);
                 }
                 else 
                 {
@@ -183,18 +734,142 @@ namespace final_project
             }
         }
 
-        void generate_lexer(const std::string& filename)
+        //Returns the label of the token the DFA matches on the whole of the specified 
+        //text, or an empty string if it does not match the text
+        static std::string match_label(const automata::dfa<char>& table, const std::string& text)
+        {
+            const auto& transitions = table.get_table();
+            const auto& accepting_states = table.get_accepting_states();
+            automata::state_t state = 0;
+            for(auto c: text)
+            {
+                auto it = transitions[state].find(c);
+                if (it == transitions[state].end() || it->second == automata::ACCEPT)
+                    return std::string();
+                state = it->second;
+            }
+            auto label = table.get_accepting_labels().find(state);
+            if (label == table.get_accepting_labels().end() || 
+                    std::find(accepting_states.begin(), accepting_states.end(), state) == accepting_states.end())
+                return std::string();
+            return label->second;
+        }
+
+        //Returns true if the text can name a token type: a letter or underscore 
+        //followed by letters, digits, and underscores
+        static bool is_identifier(const std::string& text)
+        {
+            if (text.empty() || std::isdigit(static_cast<unsigned char>(text[0])))
+                return false;
+            return std::all_of(text.begin(), text.end(), [](char c)
+                {
+                    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+                });
+        }
+
+        automata::dfa<char> build_dfa(std::istream& in, keyword_sets_t& keywords, bool expand_keywords)
+        {
+            //Take out the keyword declarations, which are not regular expressions
+            std::vector<std::string> lines;
+            std::set<std::string> rules;
+            std::string line;
+            keywords.clear();
+            while(getline(in, line))
+            {
+                size_t colon_index = line.find(":");
+                if (line.compare(0, 9, "keywords ") == 0 && colon_index != line.npos)
+                {
+                    std::istringstream rule_in(line.substr(9, colon_index - 9));
+                    std::string rule;
+                    rule_in >> rule;
+                    auto& keyword_set = keywords[rule];
+                    std::istringstream keywords_in(line.substr(colon_index + 1));
+                    std::string keyword;
+                    while(keywords_in >> keyword)
+                    {
+                        if (std::find(keyword_set.begin(), keyword_set.end(), keyword) == keyword_set.end())
+                            keyword_set.push_back(keyword);
+                    }
+                    continue;
+                }
+                if (!line.empty() && line[0] != '#')
+                    rules.insert(line.substr(0, colon_index));
+                lines.push_back(line);
+            }
+            for(const auto& keyword_set: keywords)
+            {
+                if (rules.find(keyword_set.first) == rules.end())
+                    throw exceptions::invalid_regex_exception("Keywords declared for unknown rule " + keyword_set.first);
+                if (keyword_set.second.empty())
+                    throw exceptions::invalid_regex_exception("No keywords declared for rule " + keyword_set.first);
+                for(const auto& keyword: keyword_set.second)
+                {
+                    //Each keyword names a token type and is written into the lexer as a string
+                    if (!is_identifier(keyword))
+                        throw exceptions::invalid_regex_exception("Keyword " + keyword + " is not an identifier");
+                    if (rules.find(keyword) != rules.end())
+                        throw exceptions::invalid_regex_exception("Keyword " + keyword + " has the name of a rule");
+                }
+            }
+            auto build = [&lines, &keywords](bool expand)
+                {
+                    //A keyword's expression comes before its rule so that it takes priority
+                    std::stringstream spec;
+                    for(const auto& l: lines)
+                    {
+                        auto keyword_set = keywords.find(l.substr(0, l.find(":")));
+                        if (expand && !l.empty() && l[0] != '#' && keyword_set != keywords.end())
+                        {
+                            for(const auto& keyword: keyword_set->second)
+                                spec << keyword << ": " << keyword << "\n";
+                        }
+                        spec << l << "\n";
+                    }
+                    //Convert the regular expressions to postfix notation
+                    regex::regex_parser parser(spec);
+                    auto parsed = parser.parse();
+                    //Create NFA
+                    automata::nfa n = automata::build_nfa(parsed);
+                    //Create DFA 
+                    return automata::powerset_construction(n);
+                };
+            automata::dfa<char> d = build(false);
+            for(const auto& keyword_set: keywords)
+            {
+                for(const auto& keyword: keyword_set.second)
+                {
+                    if (match_label(d, keyword) != keyword_set.first)
+                        throw exceptions::invalid_regex_exception("Keyword " + keyword + " is not matched by " + keyword_set.first);
+                }
+            }
+            if (expand_keywords && !keywords.empty())
+                return build(true);
+            return d;
+        }
+
+        automata::dfa<char> build_dfa(std::istream& in)
+        {
+            keyword_sets_t keywords;
+            return build_dfa(in, keywords, true);
+        }
+
+        void generate_lexer(const std::string& filename, const lexer_options& options)
         {
             std::ifstream fin(filename.c_str());
             if(!fin.is_open())
                 throw exceptions::file_not_found_exception("Could not open file");
-            //Convert file with regular expressions to postfix notation
-            regex::regex_parser parser(fin);
-            auto parsed = parser.parse();
-            //Create NFA
-            automata::nfa n = automata::build_nfa(parsed);
-            //Create DFA 
-            automata::dfa<char> d = automata::powerset_construction(n);
+            //The header only lexer has no keyword lookup, so its DFA recognizes the keywords
+            keyword_sets_t keywords;
+            automata::dfa<char> d = build_dfa(fin, keywords, options._M_header_only);
+            if (options._M_header_only)
+            {
+                std::ifstream skeleton_hh_in("lexer_template_skeleton.hh");
+                std::ofstream lexer_hh_out("lexer.hh");
+                generate_hh(skeleton_hh_in, lexer_hh_out, d, keyword_sets_t(), options);
+                skeleton_hh_in.close();
+                lexer_hh_out.close();
+                return;
+            }
             //File streams connected to skeletons 
             std::ifstream skeleton_hh_in("lexer_skeleton.hh");
             std::cout << skeleton_hh_in.is_open() << std::endl;
@@ -204,8 +879,8 @@ namespace final_project
             std::ofstream lexer_cpp_out("lexer.cpp");
 
             //Create .hh file
-            generate_hh(skeleton_hh_in, lexer_hh_out, d.get_accepting_labels());
-            generate_lexer_cpp(skeleton_cpp_in, lexer_cpp_out, d);
+            generate_hh(skeleton_hh_in, lexer_hh_out, d, keywords, options);
+            generate_lexer_cpp(skeleton_cpp_in, lexer_cpp_out, d, keywords, options);
             //Close file streams
             skeleton_hh_in.close();
             skeleton_cpp_in.close();
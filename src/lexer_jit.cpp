@@ -0,0 +1,165 @@
+#include "lexer/lexer_jit.hh"
+
+#include <initializer_list>
+#include <utility>
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+#define LEXER_JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace final_project
+{
+    namespace lexer
+    {
+    #ifdef LEXER_JIT_X86_64
+        //Appends x86-64 instructions to a buffer and remembers the jumps whose
+        //targets are only known once every state has been emitted
+        struct code_buffer
+        {
+            void byte(uint8_t b)
+            {
+                _M_code.push_back(b);
+            }
+
+            void bytes(std::initializer_list<uint8_t> bs)
+            {
+                _M_code.insert(_M_code.end(), bs.begin(), bs.end());
+            }
+
+            void imm32(int32_t value)
+            {
+                uint32_t v = static_cast<uint32_t>(value);
+                for(int i = 0; i < 4; ++i)
+                    byte(static_cast<uint8_t>(v >> (8 * i)));
+            }
+
+            //Leaves room for the 32 bit displacement of a jump to the specified state
+            void jump_target(size_t state)
+            {
+                _M_fixups.push_back(std::make_pair(_M_code.size(), state));
+                imm32(0);
+            }
+
+            std::vector<uint8_t> _M_code;
+            //The offset of each displacement and the state it jumps to
+            std::vector<std::pair<size_t, size_t>> _M_fixups;
+        };
+
+        //Emits the code of every state. Each block starts with the increment that moves
+        //past the character of the transition into the state, so jumps go to the start of
+        //the block; the function itself enters the start state just after its increment.
+        //
+        //  state_i:  inc rdi
+        //            movzx eax, byte [rdi]
+        //            cmp eax, c / je state_j                          (single character)
+        //            lea ecx, [rax - lo] / cmp ecx, hi - lo / jbe state_j   (range)
+        //            ...
+        //            mov dword [rsi], i
+        //            mov rax, rdi
+        //            ret
+        static std::vector<uint8_t> emit_states(const std::vector<int32_t>& next, const std::vector<uint8_t>& classes,
+            size_t num_classes)
+        {
+            size_t num_states = next.size() / num_classes;
+            code_buffer code;
+            std::vector<size_t> blocks(num_states);
+            for(size_t state = 0; state < num_states; ++state)
+            {
+                blocks[state] = code._M_code.size();
+                code.bytes({0x48, 0xFF, 0xC7});
+                code.bytes({0x0F, 0xB6, 0x07});
+                int c = 0;
+                while(c < 256)
+                {
+                    int32_t target = next[state * num_classes + classes[c]];
+                    int lo = c;
+                    while(c < 256 && next[state * num_classes + classes[c]] == target)
+                        ++c;
+                    if (target < 0)
+                        continue;
+                    int hi = c - 1;
+                    size_t target_state = static_cast<size_t>(target) / num_classes;
+                    if (lo == hi)
+                    {
+                        code.byte(0x3D);
+                        code.imm32(lo);
+                        code.bytes({0x0F, 0x84});
+                    }
+                    else
+                    {
+                        code.bytes({0x8D, 0x88});
+                        code.imm32(-lo);
+                        code.bytes({0x81, 0xF9});
+                        code.imm32(hi - lo);
+                        code.bytes({0x0F, 0x86});
+                    }
+                    code.jump_target(target_state);
+                }
+                code.bytes({0xC7, 0x06});
+                code.imm32(static_cast<int32_t>(state));
+                code.bytes({0x48, 0x89, 0xF8});
+                code.byte(0xC3);
+            }
+            for(const auto& fixup: code._M_fixups)
+            {
+                int32_t displacement = static_cast<int32_t>(blocks[fixup.second]) - static_cast<int32_t>(fixup.first + 4);
+                std::memcpy(&code._M_code[fixup.first], &displacement, sizeof(displacement));
+            }
+            return code._M_code;
+        }
+    #endif
+
+        lexer_jit::lexer_jit(const std::vector<int32_t>& next, const std::vector<uint8_t>& classes, size_t num_classes)
+            : _M_code(nullptr), _M_mapping_length(0), _M_code_size(0), _M_function(nullptr)
+        {
+        #ifdef LEXER_JIT_X86_64
+            if (num_classes == 0 || next.empty())
+                return;
+            std::vector<uint8_t> code = emit_states(next, classes, num_classes);
+            size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            size_t length = (code.size() + page - 1) / page * page;
+            void* mapping = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapping == MAP_FAILED)
+                return;
+            std::memcpy(mapping, code.data(), code.size());
+            //Never writable and executable at the same time
+            if (::mprotect(mapping, length, PROT_READ | PROT_EXEC) != 0)
+            {
+                ::munmap(mapping, length);
+                return;
+            }
+            _M_code = mapping;
+            _M_mapping_length = length;
+            _M_code_size = code.size();
+            //Enter the start state after its increment
+            _M_function = reinterpret_cast<scan_function_t>(static_cast<char*>(mapping) + 3);
+        #else
+            (void)next;
+            (void)classes;
+            (void)num_classes;
+        #endif
+        }
+
+        lexer_jit::~lexer_jit()
+        {
+        #ifdef LEXER_JIT_X86_64
+            if (_M_code)
+                ::munmap(_M_code, _M_mapping_length);
+        #endif
+        }
+
+        lexer_jit::scan_function_t lexer_jit::function() const
+        {
+            return _M_function;
+        }
+
+        size_t lexer_jit::code_size() const
+        {
+            return _M_code_size;
+        }
+    } // namespace lexer
+
+} // namespace final_project
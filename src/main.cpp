@@ -3,6 +3,28 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstring>
+
+//Command line options:
+//  --compress            emit row displacement compressed tables, with default reductions and 
+//                        shared rows in the parse tables
+//  --report-compression  print how much the tables were compressed
+//  --no-simd             do not emit vectorized loops for self-looping lexer states
+//  --owning-tokens       store a copy of the text in every token the lexer produces
+//  --header-only         emit the lexer as a header-only template over constexpr tables
+//  --profile <file>      lay out the lexer's goto code using a profile from an instrumented lexer
+//  --extended-grammar    compute the parser's lookaheads from the extended grammar instead of 
+//                        DeRemer and Pennello's relations
+//  --lr1                 build LR(1) states, merging only the states Pager's weak compatibility allows
+//  --canonical-lr1       build the canonical LR(1) states without merging any
+bool compress_tables = false;
+bool report_compression = false;
+bool simd_self_loops = true;
+bool owning_tokens = false;
+bool header_only = false;
+std::string profile;
+final_project::parser::parser_generator::lookahead_method_t lookahead_method = 
+    final_project::parser::parser_generator::LA_DEREMER_PENNELLO;
 
 void generate_lexer()
 {
@@ -20,7 +42,14 @@ void generate_lexer()
         fin.close();
         fin.open(filename.c_str());
     }
-    final_project::lexer::generate_lexer(filename);
+    final_project::lexer::lexer_options options;
+    options._M_compress_tables = compress_tables;
+    options._M_report_compression = report_compression;
+    options._M_simd_self_loops = simd_self_loops;
+    options._M_owning_tokens = owning_tokens;
+    options._M_header_only = header_only;
+    options._M_profile = profile;
+    final_project::lexer::generate_lexer(filename, options);
 }
 
 void generate_parser_tables()
@@ -39,14 +68,54 @@ void generate_parser_tables()
         fin.close();
         fin.open(filename.c_str());
     }
-    final_project::parser::parser_generator pg(fin);
+    final_project::parser::parser_generator pg(fin, lookahead_method);
     auto tables = pg.create_parse_tables();
     std::ofstream fout("Parser Table.txt");
     final_project::parser::parser_generator::print_tables(fout, tables.first, tables.second);
+    if (compress_tables || report_compression)
+    {
+        auto compressed = final_project::parser::parser_generator::compress_tables(tables.first, tables.second);
+        if (compress_tables)
+        {
+            fout << "\n\n";
+            final_project::parser::parser_generator::print_compressed_tables(fout, compressed);
+        }
+        if (report_compression)
+        {
+            size_t states = compressed._M_action_rows.size();
+            size_t action_dense = states * compressed._M_action_columns.size();
+            size_t goto_dense = states * compressed._M_goto_columns.size();
+            std::cout << "Action table: " << action_dense << " entries uncompressed, " << compressed.action_size() 
+                << " entries compressed (ratio " << static_cast<double>(action_dense) / compressed.action_size() << ")\n";
+            std::cout << "GOTO table: " << goto_dense << " entries uncompressed, " << compressed.goto_size() 
+                << " entries compressed (ratio " << static_cast<double>(goto_dense) / compressed.goto_size() << ")" << std::endl;
+        }
+    }
 }
 
 int main(int argc, char** argv)
 {
+    for(int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--compress") == 0)
+            compress_tables = true;
+        else if (std::strcmp(argv[i], "--report-compression") == 0)
+            report_compression = true;
+        else if (std::strcmp(argv[i], "--no-simd") == 0)
+            simd_self_loops = false;
+        else if (std::strcmp(argv[i], "--owning-tokens") == 0)
+            owning_tokens = true;
+        else if (std::strcmp(argv[i], "--header-only") == 0)
+            header_only = true;
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+            profile = argv[++i];
+        else if (std::strcmp(argv[i], "--extended-grammar") == 0)
+            lookahead_method = final_project::parser::parser_generator::LA_EXTENDED_GRAMMAR;
+        else if (std::strcmp(argv[i], "--lr1") == 0)
+            lookahead_method = final_project::parser::parser_generator::LA_PAGER_LR1;
+        else if (std::strcmp(argv[i], "--canonical-lr1") == 0)
+            lookahead_method = final_project::parser::parser_generator::LA_CANONICAL_LR1;
+    }
     std::cout << "Select option:\n[1] Generate Lexer\n[2] Generate Parser Tables" << std::endl;
     std::string option;
     std::cin >> option; 
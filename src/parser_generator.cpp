@@ -1,26 +1,40 @@
 #include "parser/parser_generator.hh"
 #include "exception/exceptions.hh"
 
-#include <queue>
 #include <sstream>
 #include <iterator>
 #include <iostream>
+#include <stdexcept>
+#include <map>
 
 namespace final_project
 {
     namespace parser
     {
 
-       parser_generator::parser_generator(std::istream& in)
-            : _M_in(in), _M_terminals(), _M_inputs(), _M_grammar(), _M_translation_table(),
-            _M_first_sets{}, _M_follow_sets{}, _M_extended_grammar()
+       parser_generator::parser_generator(std::istream& in, lookahead_method_t method)
+            : _M_in(in), _M_method(method), _M_symbols(), _M_terminals(), _M_inputs(), _M_start(NO_SYMBOL), _M_eof(NO_SYMBOL), 
+            _M_epsilon(NO_SYMBOL), _M_grammar(), _M_closures(), _M_translation_table(), _M_reductions(), _M_first_sets{}, _M_follow_sets{}, 
+            _M_extended_grammar()
         {
             parse_grammar(_M_in);
         }
 
-        bool parser_generator::is_terminal(const std::string& str) const 
+        bool parser_generator::is_terminal(symbol_t symbol) const 
         {
-            return _M_terminals.find(str) != _M_terminals.end();
+            return _M_terminals[symbol];
+        }
+
+        symbol_t parser_generator::next_symbol(item_t item) const 
+        {
+            const auto& rhs = _M_grammar[item_production(item)]._M_rhs;
+            size_t dot = item_dot(item);
+            return dot < rhs.size() ? rhs[dot] : NO_SYMBOL;
+        }
+
+        const symbol_table& parser_generator::get_symbols() const 
+        {
+            return _M_symbols;
         }
 
         const std::vector<parser_generator::rule_t>& parser_generator::get_grammar() const 
@@ -31,6 +45,9 @@ namespace final_project
         void parser_generator::parse_grammar(std::istream& in)
         {
             std::string line;
+            std::set<std::string> terminals;
+            std::set<std::string> inputs;
+            std::vector<std::pair<std::string, std::vector<std::string>>> rules;
             //Read in rules 
             while(getline(in, line))
             {
@@ -42,7 +59,7 @@ namespace final_project
                     std::string terminal;
                     for(; !(terminal_itr == std::istream_iterator<std::string>()); ++terminal_itr)
                     {
-                        _M_terminals.insert(*terminal_itr);
+                        terminals.insert(*terminal_itr);
                     }
                     continue;
                 }
@@ -51,139 +68,558 @@ namespace final_project
                 std::stringstream rule_ss(line);
                 std::istream_iterator<std::string> itr(rule_ss);
                 std::string lhs = *itr++;
-                _M_inputs.insert(lhs);
+                inputs.insert(lhs);
                 ++itr; //skip ->
                 std::vector<std::string> rhs;
                 if(itr == std::istream_iterator<std::string>()) //RHS is epsilon
-                    rhs.push_back("\0");
+                    rhs.push_back(std::string());
                 for(; !(itr == std::istream_iterator<std::string>()); ++itr)
                 {
                     rhs.push_back(*itr);
-                    _M_inputs.insert(*itr);
+                    inputs.insert(*itr);
                 }
                 if (lhs == "S")
                     rhs.push_back(TP_EOF);
-                rule_t r = {0, lhs, rhs};
+                rules.push_back(std::make_pair(lhs, rhs));
+            }
+            //Intern every name once; from here on symbols are ids
+            std::set<std::string> names(terminals);
+            names.insert(inputs.begin(), inputs.end());
+            names.insert(TP_EOF);
+            for(const auto& rule: rules)
+                names.insert(rule.second.begin(), rule.second.end());
+            _M_symbols = symbol_table(names.begin(), names.end());
+            _M_terminals.assign(_M_symbols.size(), false);
+            for(const auto& terminal: terminals)
+                _M_terminals[_M_symbols.find(terminal)] = true;
+            for(const auto& input: inputs)
+                _M_inputs.push_back(_M_symbols.find(input));
+            _M_start = _M_symbols.find("S");
+            _M_eof = _M_symbols.find(TP_EOF);
+            _M_epsilon = _M_symbols.find("");
+            for(const auto& rule: rules)
+            {
+                rule_t r = {_M_symbols.find(rule.first), {}};
+                for(const auto& symbol: rule.second)
+                    r._M_rhs.push_back(_M_symbols.find(symbol));
                 _M_grammar.push_back(r);
             }
         }
 
         std::vector<parser_generator::item_set_t> parser_generator::create_item_sets()
         {
-            auto I0 = create_item_set(_M_grammar.front());
-            std::set<item_set_t> item_sets;
-            std::queue<item_set_t> work_list;
-            work_list.push(I0);
-            item_sets.insert(I0);
+            create_closures();
 
-            while(!work_list.empty())
+            //An item set is the closure of its kernel, so sets are the same if their kernels are
+            std::unordered_map<std::vector<item_t>, size_t, kernel_hash> states;
+            std::vector<item_set_t> item_sets;
+            std::vector<item_t> start = {make_item(0, 0)};
+            states[start] = 0;
+            item_sets.push_back(create_item_set(start));
+            _M_translation_table.assign(1, {});
+
+            //The goto kernel on each symbol of the current set, and the symbols that have one
+            std::vector<std::vector<item_t>> kernels(_M_symbols.size());
+            std::vector<symbol_t> symbols;
+            //Sets are numbered in the order they are found, so the sets after the 
+            //current one are the work list
+            for(size_t i = 0; i < item_sets.size(); ++i)
             {
-                auto curr_set = work_list.front();
-                work_list.pop();
+                goto_kernels(item_sets[i], kernels, symbols);
+                for(symbol_t symbol: symbols)
+                {
+                    auto inserted = states.insert(std::make_pair(kernels[symbol], item_sets.size()));
+                    //If we have not already seen the kernel, create its item set
+                    if (inserted.second)
+                    {
+                        item_sets.push_back(create_item_set(kernels[symbol]));
+                        _M_translation_table.emplace_back();
+                    }
+                    _M_translation_table[i][symbol] = inserted.first->second;
+                    kernels[symbol].clear();
+                }
+            }
+            return item_sets;
+        }
+
+        void parser_generator::create_closures()
+        {
+            //Every item must fit in an item_t
+            size_t max_length = 0;
+            for(const auto& rule: _M_grammar)
+                max_length = std::max(max_length, rule._M_rhs.size());
+            if (max_length >= (1u << ITEM_DOT_BITS) || 
+                    _M_grammar.size() > (std::numeric_limits<item_t>::max() >> ITEM_DOT_BITS))
+                throw std::length_error("The grammar has too many rules or too long a rule");
 
-                for(const auto& input: _M_inputs)
+            //The productions of each nonterminal and the nonterminals its productions start with
+            std::vector<dynamic_bitset> productions(_M_symbols.size());
+            std::vector<std::vector<symbol_t>> starts(_M_symbols.size());
+            for(size_t i = 0; i < _M_grammar.size(); ++i)
+            {
+                const auto& rule = _M_grammar[i];
+                if (productions[rule._M_lhs].size() == 0)
+                    productions[rule._M_lhs] = dynamic_bitset(_M_grammar.size());
+                productions[rule._M_lhs].set(i);
+                symbol_t first = rule._M_rhs.front();
+                if (!is_terminal(first) && first != _M_epsilon && first != _M_eof)
+                    starts[rule._M_lhs].push_back(first);
+            }
+
+            //The closure of a nonterminal holds the productions of every nonterminal reachable 
+            //through the first symbols of productions
+            _M_closures.assign(_M_symbols.size(), dynamic_bitset());
+            std::vector<bool> visited(_M_symbols.size());
+            std::vector<symbol_t> work_list;
+            for(symbol_t nt = 0; nt < _M_symbols.size(); ++nt)
+            {
+                if (is_terminal(nt))
+                    continue;
+                _M_closures[nt] = dynamic_bitset(_M_grammar.size());
+                std::fill(visited.begin(), visited.end(), false);
+                visited[nt] = true;
+                work_list.push_back(nt);
+                while(!work_list.empty())
                 {
-                    //Find rules "expecting" the given input 
-                    auto rules = curr_set._M_rules;
-                    for(auto rule : rules)
+                    symbol_t curr = work_list.back();
+                    work_list.pop_back();
+                    if (productions[curr].size() != 0)
+                        _M_closures[nt].merge(productions[curr]);
+                    for(symbol_t next: starts[curr])
                     {
-                        //Create a new item set with the rule as the kernel
-                        if(rule._M_pointer < rule._M_rhs.size() && rule._M_rhs[rule._M_pointer] == input)
+                        if (!visited[next])
                         {
-                            auto item_set = create_item_set(++rule);
-                            bool inserted = item_sets.insert(item_set).second;
-                            //If we have not already seen the item set, add it to the work list
-                            if (inserted)
-                                work_list.push(item_set);
+                            visited[next] = true;
+                            work_list.push_back(next);
                         }
                     }
                 }
             }
-            return std::vector<parser_generator::item_set_t>(item_sets.begin(), item_sets.end());
         }
 
-        parser_generator::item_set_t parser_generator::create_item_set(const rule_t& kernel)
+        void parser_generator::create_symbol_first_sets()
         {
-            item_set_t I;
-            I.add_rule(kernel);
-            std::queue<rule_t> work_list;
-            work_list.push(kernel);
+            const size_t num_symbols = _M_symbols.size();
+            //The rules each symbol occurs in, once for every occurrence, and the number of 
+            //symbols of each rule not known to be nullable
+            std::vector<std::vector<size_t>> occurrences(num_symbols);
+            std::vector<size_t> remaining(_M_grammar.size());
+            for(size_t i = 0; i < _M_grammar.size(); ++i)
+            {
+                remaining[i] = _M_grammar[i]._M_rhs.size();
+                for(symbol_t symbol: _M_grammar[i]._M_rhs)
+                    occurrences[symbol].push_back(i);
+            }
+            _M_symbol_nullable.assign(num_symbols, false);
+            std::vector<symbol_t> work_list;
+            if (_M_epsilon != NO_SYMBOL)
+            {
+                _M_symbol_nullable[_M_epsilon] = true;
+                work_list.push_back(_M_epsilon);
+            }
+            while(!work_list.empty())
+            {
+                symbol_t symbol = work_list.back();
+                work_list.pop_back();
+                for(size_t rule: occurrences[symbol])
+                {
+                    symbol_t lhs = _M_grammar[rule]._M_lhs;
+                    if (--remaining[rule] == 0 && !_M_symbol_nullable[lhs])
+                    {
+                        _M_symbol_nullable[lhs] = true;
+                        work_list.push_back(lhs);
+                    }
+                }
+            }
 
-            //Similar to BFS
+            //The left hand sides of the rules each symbol begins after nullable symbols
+            std::vector<std::vector<symbol_t>> dependents(num_symbols);
+            for(const auto& rule: _M_grammar)
+            {
+                for(symbol_t symbol: rule._M_rhs)
+                {
+                    dependents[symbol].push_back(rule._M_lhs);
+                    if (!_M_symbol_nullable[symbol])
+                        break;
+                }
+            }
+            //A terminal, or the $ that ends the S rule, is its own first set
+            _M_symbol_first.assign(num_symbols, dynamic_bitset(num_symbols));
+            std::vector<bool> queued(num_symbols, false);
+            for(symbol_t symbol = 0; symbol < num_symbols; ++symbol)
+            {
+                if (is_terminal(symbol) || symbol == _M_eof)
+                {
+                    _M_symbol_first[symbol].set(symbol);
+                    queued[symbol] = true;
+                    work_list.push_back(symbol);
+                }
+            }
             while(!work_list.empty())
             {
-                auto rule = work_list.front();
-                work_list.pop();
-                //If pointer is at end of rule, there is nothing to be done
-                if (rule._M_pointer >= rule._M_rhs.size())
-                    continue;
+                symbol_t symbol = work_list.back();
+                work_list.pop_back();
+                queued[symbol] = false;
+                for(symbol_t lhs: dependents[symbol])
+                {
+                    if (_M_symbol_first[lhs].merge(_M_symbol_first[symbol]) && !queued[lhs])
+                    {
+                        queued[lhs] = true;
+                        work_list.push_back(lhs);
+                    }
+                }
+            }
+        }
 
-                std::string first = rule._M_rhs[rule._M_pointer];
-                if(!is_terminal(first))
+        bool parser_generator::first_of(const std::vector<symbol_t>& rhs, size_t from, dynamic_bitset& set) const
+        {
+            for(size_t i = from; i < rhs.size(); ++i)
+            {
+                set.merge(_M_symbol_first[rhs[i]]);
+                if (!_M_symbol_nullable[rhs[i]])
+                    return false;
+            }
+            return true;
+        }
+
+        bool parser_generator::weakly_compatible(const std::vector<dynamic_bitset>& lhs, const std::vector<dynamic_bitset>& rhs)
+        {
+            //Merging can only add a conflict between two items that get a common lookahead from 
+            //different states and that have none in common in either state
+            for(size_t i = 0; i < lhs.size(); ++i)
+            {
+                for(size_t j = i + 1; j < lhs.size(); ++j)
+                {
+                    if ((lhs[i].intersects(rhs[j]) || lhs[j].intersects(rhs[i])) && 
+                            !lhs[i].intersects(lhs[j]) && !rhs[i].intersects(rhs[j]))
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        std::vector<parser_generator::item_set_t> parser_generator::create_lr1_item_sets(bool merge)
+        {
+            create_closures();
+            create_symbol_first_sets();
+            const size_t num_symbols = _M_symbols.size();
+            auto is_nonterminal = [&](symbol_t symbol)
+                {
+                    return symbol != NO_SYMBOL && !is_terminal(symbol) && symbol != _M_eof && symbol != _M_epsilon;
+                };
+
+            //The productions of each nonterminal, and what follows the first symbol of each production
+            std::vector<std::vector<size_t>> productions(num_symbols);
+            std::vector<dynamic_bitset> tail_first(_M_grammar.size(), dynamic_bitset(num_symbols));
+            std::vector<bool> tail_nullable(_M_grammar.size());
+            for(size_t i = 0; i < _M_grammar.size(); ++i)
+            {
+                productions[_M_grammar[i]._M_lhs].push_back(i);
+                tail_nullable[i] = first_of(_M_grammar[i]._M_rhs, 1, tail_first[i]);
+            }
+
+            struct lr1_state_t
+            {
+                std::vector<item_t> _M_kernel;
+                std::vector<dynamic_bitset> _M_lookaheads;
+            };
+            std::vector<lr1_state_t> states;
+            //The states with each LR(0) kernel
+            std::unordered_map<std::vector<item_t>, std::vector<size_t>, kernel_hash> cores;
+            std::vector<bool> queued;
+            std::vector<size_t> work_list;
+            _M_translation_table.clear();
+            _M_reductions.clear();
+
+            //Returns the state the specified kernel goes to, merging it into a compatible 
+            //state or creating a new one
+            auto find_state = [&](const std::vector<item_t>& kernel, const std::vector<dynamic_bitset>& lookaheads)
                 {
-                    for(const auto& r: _M_grammar)
+                    auto& candidates = cores[kernel];
+                    for(size_t candidate: candidates)
                     {
-                        if(r._M_lhs == first)
+                        auto& state = states[candidate];
+                        if (merge ? !weakly_compatible(lookaheads, state._M_lookaheads) : lookaheads != state._M_lookaheads)
+                            continue;
+                        bool grew = false;
+                        for(size_t i = 0; i < lookaheads.size(); ++i)
+                            grew = state._M_lookaheads[i].merge(lookaheads[i]) || grew;
+                        //The new lookaheads have to be passed on to the state's successors
+                        if (grew && !queued[candidate])
                         {
-                            if(!I.has_rule(r))
-                            {
-                                I.add_rule(r);
-                                work_list.push(r);
-                            }
+                            queued[candidate] = true;
+                            work_list.push_back(candidate);
                         }
+                        return candidate;
                     }
+                    size_t id = states.size();
+                    states.push_back({kernel, lookaheads});
+                    candidates.push_back(id);
+                    queued.push_back(true);
+                    work_list.push_back(id);
+                    _M_translation_table.emplace_back();
+                    _M_reductions.emplace_back();
+                    return id;
+                };
+            find_state({make_item(0, 0)}, {dynamic_bitset(num_symbols)});
+
+            //The lookaheads of the start items of each nonterminal in the current state, 
+            //and whether the nonterminal has been reached in it
+            std::vector<dynamic_bitset> closure_lookaheads(num_symbols);
+            std::vector<bool> reached(num_symbols);
+            std::vector<bool> pending(num_symbols);
+            std::vector<symbol_t> touched, pending_list;
+            //The goto kernel on each symbol with the lookaheads of its items
+            std::vector<std::vector<item_t>> kernels(num_symbols);
+            std::vector<std::vector<dynamic_bitset>> kernel_lookaheads(num_symbols);
+            std::vector<symbol_t> symbols;
+            while(!work_list.empty())
+            {
+                size_t curr = work_list.back();
+                work_list.pop_back();
+                queued[curr] = false;
+                //find_state can add states, so work on copies
+                const std::vector<item_t> kernel = states[curr]._M_kernel;
+                const std::vector<dynamic_bitset> lookaheads = states[curr]._M_lookaheads;
+                item_set_t closure = create_item_set(kernel);
+
+                auto add_pending = [&](symbol_t nt)
+                    {
+                        if (!pending[nt])
+                        {
+                            pending[nt] = true;
+                            pending_list.push_back(nt);
+                        }
+                    };
+                //Every nonterminal goes on the pending list when it is first reached, so 
+                //the lookaheads of its productions are passed on even if its own are empty
+                auto add_lookaheads = [&](symbol_t nt) -> dynamic_bitset&
+                    {
+                        auto& set = closure_lookaheads[nt];
+                        if (!reached[nt])
+                        {
+                            reached[nt] = true;
+                            touched.push_back(nt);
+                            if (set.size() == 0)
+                                set = dynamic_bitset(num_symbols);
+                            add_pending(nt);
+                        }
+                        return set;
+                    };
+                //A nonterminal after the dot of a kernel item is followed by the rest of the 
+                //item, or the item's lookaheads if the rest is nullable
+                for(size_t i = 0; i < kernel.size(); ++i)
+                {
+                    symbol_t symbol = next_symbol(kernel[i]);
+                    if (!is_nonterminal(symbol))
+                        continue;
+                    auto& set = add_lookaheads(symbol);
+                    if (first_of(_M_grammar[item_production(kernel[i])]._M_rhs, item_dot(kernel[i]) + 1, set))
+                        set.merge(lookaheads[i]);
                 }
+                //Pass the lookaheads on through the start items until nothing changes
+                while(!pending_list.empty())
+                {
+                    symbol_t nt = pending_list.back();
+                    pending_list.pop_back();
+                    pending[nt] = false;
+                    for(size_t production: productions[nt])
+                    {
+                        symbol_t first = _M_grammar[production]._M_rhs.front();
+                        if (!is_nonterminal(first))
+                            continue;
+                        auto& set = add_lookaheads(first);
+                        bool grew = set.merge(tail_first[production]);
+                        if (tail_nullable[production])
+                            grew = set.merge(closure_lookaheads[nt]) || grew;
+                        if (grew)
+                            add_pending(first);
+                    }
+                }
+
+                //Reductions and gotos of every item
+                auto& reductions = _M_reductions[curr];
+                reductions.clear();
+                symbols.clear();
+                for(item_t item: closure._M_items)
+                {
+                    size_t production = item_production(item);
+                    auto it = std::lower_bound(kernel.begin(), kernel.end(), item);
+                    const dynamic_bitset& item_lookaheads = (it != kernel.end() && *it == item) ? 
+                        lookaheads[it - kernel.begin()] : closure_lookaheads[_M_grammar[production]._M_lhs];
+                    symbol_t symbol = next_symbol(item);
+                    if (symbol == NO_SYMBOL || symbol == _M_epsilon)
+                    {
+                        //The S rule is accepted instead
+                        if (_M_grammar[production]._M_lhs != _M_start)
+                            reductions.push_back({production, item_lookaheads});
+                        continue;
+                    }
+                    if (symbol == _M_eof)
+                        continue;
+                    if (kernels[symbol].empty())
+                        symbols.push_back(symbol);
+                    kernels[symbol].push_back(item + 1);
+                    kernel_lookaheads[symbol].push_back(item_lookaheads);
+                }
+                std::sort(symbols.begin(), symbols.end());
+                for(symbol_t symbol: symbols)
+                {
+                    size_t next = find_state(kernels[symbol], kernel_lookaheads[symbol]);
+                    _M_translation_table[curr][symbol] = next;
+                    kernels[symbol].clear();
+                    kernel_lookaheads[symbol].clear();
+                }
+                for(symbol_t nt: touched)
+                {
+                    closure_lookaheads[nt].clear();
+                    reached[nt] = false;
+                }
+                touched.clear();
+            }
+
+            //Number the reachable states in the order they are reached
+            const size_t UNREACHED = std::numeric_limits<size_t>::max();
+            std::vector<size_t> number(states.size(), UNREACHED);
+            std::vector<size_t> order = {0};
+            number[0] = 0;
+            for(size_t i = 0; i < order.size(); ++i)
+            {
+                std::map<symbol_t, size_t> row(_M_translation_table[order[i]].begin(), _M_translation_table[order[i]].end());
+                for(const auto& transition: row)
+                {
+                    if (number[transition.second] == UNREACHED)
+                    {
+                        number[transition.second] = order.size();
+                        order.push_back(transition.second);
+                    }
+                }
+            }
+            translation_table_t table(order.size());
+            std::vector<std::vector<reduction_t>> reductions(order.size());
+            std::vector<item_set_t> item_sets(order.size());
+            for(size_t i = 0; i < order.size(); ++i)
+            {
+                for(const auto& transition: _M_translation_table[order[i]])
+                    table[i][transition.first] = number[transition.second];
+                reductions[i] = std::move(_M_reductions[order[i]]);
+                item_sets[i] = create_item_set(states[order[i]]._M_kernel);
+            }
+            _M_translation_table = std::move(table);
+            _M_reductions = std::move(reductions);
+            return item_sets;
+        }
+
+        parser_generator::item_set_t parser_generator::create_item_set(const std::vector<item_t>& kernel)
+        {
+            //The closure is the union of the closures of the nonterminals after the dots
+            dynamic_bitset closure(_M_grammar.size());
+            for(item_t item: kernel)
+            {
+                symbol_t symbol = next_symbol(item);
+                if (symbol != NO_SYMBOL && !is_terminal(symbol))
+                    closure.merge(_M_closures[symbol]);
             }
+            std::vector<item_t> added;
+            closure.for_each([&](size_t production)
+                {
+                    added.push_back(make_item(production, 0));
+                });
+
+            //Both lists are sorted, so merging them keeps the items in order
+            item_set_t I;
+            I._M_items.resize(kernel.size() + added.size());
+            auto end = std::set_union(kernel.begin(), kernel.end(), added.begin(), added.end(), I._M_items.begin());
+            I._M_items.erase(end, I._M_items.end());
             return I;
         }
 
+        std::vector<parser_generator::item_t> parser_generator::kernel(const item_set_t& set) const
+        {
+            std::vector<item_t> kernel;
+            for(item_t item: set._M_items)
+            {
+                if (item_dot(item) > 0 || item == make_item(0, 0))
+                    kernel.push_back(item);
+            }
+            return kernel;
+        }
+
+        void parser_generator::goto_kernels(const item_set_t& set, std::vector<std::vector<item_t>>& kernels, 
+            std::vector<symbol_t>& symbols) const
+        {
+            symbols.clear();
+            //The items are sorted, so each kernel is too
+            for(item_t item: set._M_items)
+            {
+                symbol_t symbol = next_symbol(item);
+                if (symbol == NO_SYMBOL || symbol == _M_eof || symbol == _M_epsilon)
+                    continue;
+                if (kernels[symbol].empty())
+                    symbols.push_back(symbol);
+                kernels[symbol].push_back(item + 1);
+            }
+            std::sort(symbols.begin(), symbols.end());
+        }
+
         void parser_generator::create_translation_table(const std::vector<parser_generator::item_set_t>& sets)
         {
             _M_translation_table.resize(sets.size());
-            //Iterator over item set 
+            //Index the sets by kernel, so finding the set reached on an input needs neither 
+            //a closure nor a search of the sets
+            std::unordered_map<std::vector<item_t>, size_t, kernel_hash> states;
+            for(size_t i = 0; i < sets.size(); ++i)
+                states.insert(std::make_pair(kernel(sets[i]), i));
+
+            std::vector<std::vector<item_t>> kernels(_M_symbols.size());
+            std::vector<symbol_t> symbols;
             for(size_t i = 0; i < sets.size(); ++i)
             {
-                const auto& curr_set = sets[i];
-                //Give each item set each possible input
-                for(const auto& input: _M_inputs)
+                goto_kernels(sets[i], kernels, symbols);
+                for(symbol_t symbol: symbols)
                 {
-                    const auto& rules = curr_set._M_rules;
-                    for(auto rule : rules) 
-                    {
-                        //Create a new item set with the rule as the kernel
-                        if(rule._M_pointer < rule._M_rhs.size() && rule._M_rhs[rule._M_pointer] == input)
-                        {
-                            //Advance rule pointer
-                            ++rule;
-                            //Find item set containing rule 
-                            auto it = std::find_if(sets.begin(), sets.end(), [&](const item_set_t& s)
-                                {
-                                    return std::find(s._M_rules.begin(), s._M_rules.end(), rule) != 
-                                        s._M_rules.end();
-                                });
-                            //Insert into translation table
-                            if(it != sets.end())
-                                _M_translation_table[i][input] = std::distance(sets.begin(), it);
-                        }
-                    }
+                    //Insert into translation table
+                    auto it = states.find(kernels[symbol]);
+                    if (it != states.end())
+                        _M_translation_table[i][symbol] = it->second;
+                    kernels[symbol].clear();
                 }
             }
         }
 
         void parser_generator::create_extended_grammar(const std::vector<parser_generator::item_set_t>& sets)
         {
+            _M_extended_grammar.clear();
+            _M_extended_symbols.clear();
+            _M_numbered_grammar.clear();
+            //Number the symbols in the order they first appear. The state a symbol goes to is 
+            //found from its symbol and the state it starts in, so those two identify it.
+            std::unordered_map<uint64_t, size_t> numbers;
+            numbers.reserve(sets.size() * 8);
+            auto number = [&](const extended_rule_t::symbol& s)
+                {
+                    uint64_t key = uint64_t(s.second.first) * _M_symbols.size() + s.first;
+                    auto it = numbers.find(key);
+                    if (it != numbers.end())
+                        return it->second;
+                    numbers.insert(std::make_pair(key, _M_extended_symbols.size()));
+                    _M_extended_symbols.push_back(s);
+                    return _M_extended_symbols.size() - 1;
+                };
             //Iterate over all item sets
             for(size_t i = 0; i < sets.size(); ++i)
             {
                 const auto& set = sets[i];
-                for(const auto& rule: set._M_rules)
+                for(item_t item: set._M_items)
                 {
-                    if (rule._M_pointer == 0)
+                    if (item_dot(item) == 0)
                     {
+                        const auto& rule = _M_grammar[item_production(item)];
                         //Follow rule to add to grammar
                         //LHS of rule
+                        //There is no transition on S or $, so their end is sets.size()
                         size_t lhs_start = i;
-                        size_t lhs_end;
+                        size_t lhs_end = sets.size();
                         auto it = _M_translation_table[i].find(rule._M_lhs);
                         if (it != _M_translation_table[i].end())
                             lhs_end = it->second;
@@ -193,244 +629,220 @@ namespace final_project
                         size_t start = i;
                         for(const auto& symbol: rule._M_rhs)
                         {
-                            size_t end;
-                            auto it = _M_translation_table[start].find(symbol);
-                            if (it != _M_translation_table[start].end())
-                                end = it->second;
+                            size_t end = sets.size();
+                            //An epsilon rule is reduced in the state it starts in
+                            if (symbol == _M_epsilon)
+                                end = start;
+                            else if (start < sets.size())
+                            {
+                                auto it = _M_translation_table[start].find(symbol);
+                                if (it != _M_translation_table[start].end())
+                                    end = it->second;
+                            }
                             rhs_symbols.push_back({symbol, {start, end}});
                             start = end;
                         }
-                        _M_extended_grammar.push_back({lhs, rhs_symbols});
+                        numbered_rule_t numbered = {item_production(item), number(lhs), {}};
+                        numbered._M_rhs.reserve(rhs_symbols.size());
+                        for(const auto& symbol: rhs_symbols)
+                            numbered._M_rhs.push_back(number(symbol));
+                        _M_numbered_grammar.push_back(std::move(numbered));
+                        _M_extended_grammar.push_back({lhs, std::move(rhs_symbols)});
                     }
                 }
             }
-        }
-
-        bool parser_generator::nullable(const extended_rule_t::symbol& s)
-        {
-            if(s.first[0] == EPSILON)
-                return true;
-            if (s.first == "$")
-                return true;
-            if(is_terminal(s.first))
-            {
-                _M_nullable[s] = false;
-                return false;
-            }
-            else
+            _M_occurrences.assign(_M_extended_symbols.size(), {});
+            for(size_t i = 0; i < _M_numbered_grammar.size(); ++i)
             {
-                bool n = false;
-                for(const auto& rule: _M_extended_grammar)
-                {
-                    if (rule._M_lhs == s)
-                        n = n || nullable(rule._M_rhs);
-                }
-                return n;
+                const auto& rhs = _M_numbered_grammar[i]._M_rhs;
+                for(size_t j = 0; j < rhs.size(); ++j)
+                    _M_occurrences[rhs[j]].push_back(std::make_pair(i, j));
             }
         }
 
-        bool parser_generator::nullable(const std::vector<parser_generator::extended_rule_t::symbol>& s)
-        {
-            bool n = true;
-            for (const auto& symb: s)
-            {
-                n = n && _M_nullable[symb];
-            }
-            return n;
-        }
-
         void parser_generator::compute_nullables()
         {
-            std::set<extended_rule_t::symbol> non_terminals;
-            std::transform(_M_extended_grammar.begin(), _M_extended_grammar.end(), std::inserter(non_terminals, non_terminals.end()), 
-                [](const extended_rule_t& r)
+            const size_t num_symbols = _M_extended_symbols.size();
+            _M_nullable.assign(num_symbols, false);
+            //The number of symbols of each rule not known to be nullable
+            std::vector<size_t> remaining(_M_numbered_grammar.size());
+            for(size_t i = 0; i < _M_numbered_grammar.size(); ++i)
+                remaining[i] = _M_numbered_grammar[i]._M_rhs.size();
+            std::vector<size_t> work_list;
+            for(size_t symbol = 0; symbol < num_symbols; ++symbol)
+            {
+                if (_M_extended_symbols[symbol].first == _M_epsilon)
                 {
-                    return r._M_lhs;
-                });
-            for(const auto& nt: non_terminals)
-                _M_nullable[nt] = false;
-            while(true)
+                    _M_nullable[symbol] = true;
+                    work_list.push_back(symbol);
+                }
+            }
+            while(!work_list.empty())
             {
-                bool changed = false;
-                for(const auto& nt: non_terminals)
+                size_t symbol = work_list.back();
+                work_list.pop_back();
+                for(const auto& occurrence: _M_occurrences[symbol])
                 {
-                    bool old = _M_nullable[nt];
-                    _M_nullable[nt] = nullable(nt);
-                    if(_M_nullable[nt] != old)
-                        changed = true;
+                    size_t rule = occurrence.first;
+                    size_t lhs = _M_numbered_grammar[rule]._M_lhs;
+                    if (--remaining[rule] == 0 && !_M_nullable[lhs])
+                    {
+                        _M_nullable[lhs] = true;
+                        work_list.push_back(lhs);
+                    }
                 }
-                if(!changed)
-                    break;
             }
         }
 
-        std::set<std::string> parser_generator::first(const extended_rule_t::symbol& s)
-        {
-            if(is_terminal(s.first))
-                return {s.first};
-            else 
-                return _M_first_sets[s];
-        }
-
-        std::set<std::string> parser_generator::first(const std::vector<parser_generator::extended_rule_t::symbol>& s)
+        void parser_generator::create_first_sets()
         {
-            std::set<std::string> first_set;
-
-            if(s.size() == 1 || !_M_nullable[s.front()])
+            const size_t num_symbols = _M_extended_symbols.size();
+            _M_first_sets.assign(num_symbols, dynamic_bitset(_M_symbols.size()));
+            //The left hand sides of the rules each symbol begins after nullable symbols
+            std::vector<std::vector<size_t>> dependents(num_symbols);
+            for(const auto& rule: _M_numbered_grammar)
             {
-                if (is_terminal(s.front().first))
-                {
-                    first_set.insert(s.front().first);
-                }
-                else
+                for(size_t symbol: rule._M_rhs)
                 {
-                    auto set = _M_first_sets[s.front()];
-                    first_set.insert(set.begin(), set.end());
+                    dependents[symbol].push_back(rule._M_lhs);
+                    if (!_M_nullable[symbol])
+                        break;
                 }
             }
-            else
+            //A terminal, or the $ that ends the S rule, is its own first set
+            std::vector<bool> queued(num_symbols, false);
+            std::vector<size_t> work_list;
+            for(size_t symbol = 0; symbol < num_symbols; ++symbol)
             {
-                if (is_terminal(s.front().first))
+                symbol_t s = _M_extended_symbols[symbol].first;
+                if (is_terminal(s) || s == _M_eof)
                 {
-                    first_set.insert(s.front().first);
+                    _M_first_sets[symbol].set(s);
+                    queued[symbol] = true;
+                    work_list.push_back(symbol);
                 }
-                else
+            }
+            while(!work_list.empty())
+            {
+                size_t symbol = work_list.back();
+                work_list.pop_back();
+                queued[symbol] = false;
+                for(size_t lhs: dependents[symbol])
                 {
-                    auto set = _M_first_sets[s.front()];
-                    first_set.insert(set.begin(), set.end());
+                    if (_M_first_sets[lhs].merge(_M_first_sets[symbol]) && !queued[lhs])
+                    {
+                        queued[lhs] = true;
+                        work_list.push_back(lhs);
+                    }
                 }
-                auto set = first(std::vector<parser_generator::extended_rule_t::symbol>(s.begin() + 1, s.end()));
-                first_set.insert(set.begin(), set.end());
             }
-            return first_set;
         }
 
-        void parser_generator::create_first_sets()
+        //Solves F(x) = F'(x) united with F(y) for every y that x is related to, where sets 
+        //holds F' on entry and F on return. Every member of a strongly connected component 
+        //of the relation gets the same set, so each relation edge is followed once 
+        //(DeRemer and Pennello's digraph algorithm, without recursion).
+        static void digraph(const std::vector<std::vector<size_t>>& relation, std::vector<dynamic_bitset>& sets)
         {
-            std::set<extended_rule_t::symbol> non_terminals;
-            std::transform(_M_extended_grammar.begin(), _M_extended_grammar.end(), std::inserter(non_terminals, non_terminals.end()), 
-                [](const extended_rule_t& r)
+            const size_t DONE = std::numeric_limits<size_t>::max();
+            //The lowest stack depth reachable from each element, 0 if not visited and 
+            //DONE once its component is finished
+            std::vector<size_t> low(relation.size(), 0);
+            std::vector<size_t> stack;
+            //The element being traversed, its stack depth, and the index of its next edge
+            struct frame_t
+            {
+                size_t _M_element;
+                size_t _M_depth;
+                size_t _M_edge;
+            };
+            std::vector<frame_t> path;
+            for(size_t root = 0; root < relation.size(); ++root)
+            {
+                if (low[root] != 0)
+                    continue;
+                stack.push_back(root);
+                low[root] = stack.size();
+                path.push_back({root, stack.size(), 0});
+                while(!path.empty())
                 {
-                    return r._M_lhs;
-                });
-            //Assume all sets are empty
-            for(const auto& nt: non_terminals)
-                _M_first_sets[nt] = {};
-            while(true)
-            {
-                bool changed = false;
-                for(size_t i = 0; i < _M_extended_grammar.size(); ++i)
-                {
-                    auto rule = _M_extended_grammar[i];
-                    auto first_set = first(rule._M_rhs);
-                    auto it = _M_first_sets.find(rule._M_lhs);
-                    if (it == _M_first_sets.end())
+                    frame_t& frame = path.back();
+                    size_t x = frame._M_element;
+                    if (frame._M_edge < relation[x].size())
+                    {
+                        size_t y = relation[x][frame._M_edge++];
+                        if (low[y] == 0)
+                        {
+                            stack.push_back(y);
+                            low[y] = stack.size();
+                            path.push_back({y, stack.size(), 0});
+                            continue;
+                        }
+                        low[x] = std::min(low[x], low[y]);
+                        sets[x].merge(sets[y]);
+                        continue;
+                    }
+                    //x is the root of a strongly connected component, which is on the stack above it
+                    if (low[x] == frame._M_depth)
                     {
-                        _M_first_sets[rule._M_lhs] = first_set;
-                        changed = true;
+                        while(true)
+                        {
+                            size_t top = stack.back();
+                            stack.pop_back();
+                            low[top] = DONE;
+                            if (top == x)
+                                break;
+                            sets[top] = sets[x];
+                        }
                     }
-                    else 
+                    path.pop_back();
+                    if (!path.empty())
                     {
-                        auto& set = _M_first_sets[rule._M_lhs];
-                        size_t old_size = set.size();
-                        set.insert(first_set.begin(), first_set.end());
-                        if(old_size != set.size())
-                            changed = true;
+                        size_t parent = path.back()._M_element;
+                        low[parent] = std::min(low[parent], low[x]);
+                        sets[parent].merge(sets[x]);
                     }
                 }
-
-                if(!changed)
-                    break;
             }
         }
 
         void parser_generator::create_follow_sets()
         {
-            std::set<extended_rule_t::symbol> non_terminals;
-            std::transform(_M_extended_grammar.begin(), _M_extended_grammar.end(), std::inserter(non_terminals, non_terminals.end()), 
-                [](const extended_rule_t& r)
-                {
-                    return r._M_lhs;
-                });
-            //Initalize FOLLOW sets
-            for(const auto& nt : non_terminals)
+            const size_t num_symbols = _M_extended_symbols.size();
+            _M_follow_sets.assign(num_symbols, dynamic_bitset(_M_symbols.size()));
+            //Where the nullable end of each rule begins
+            std::vector<size_t> nullable_end(_M_numbered_grammar.size());
+            for(size_t i = 0; i < _M_numbered_grammar.size(); ++i)
             {
-                if(nt.first == "S")
-                    _M_follow_sets[nt].insert(TP_EOF);
-                for(const auto& rule: _M_extended_grammar)
-                {
-                    auto it = std::find(rule._M_rhs.begin(), rule._M_rhs.end(), nt);
-                    if(it != rule._M_rhs.end())
-                    {
-                        std::set<std::string> follow_set;
-                        bool found_non_nullable = false;
-                        //If there are non-nullable symbols after NT
-                        //the follow set of NT contains the first set of 
-                        //all the nullable symbols with the first set of the 
-                        //first non-nullable set
-                        while(++it != rule._M_rhs.end())
-                        {
-                            auto first_set = first(*it);
-                            for(const auto& elt: first_set)
-                            {
-                                if (elt[0] != EPSILON)
-                                    follow_set.insert(elt);
-                            }
-                            //If symbol is nullable, stop taking union of FIRST sets 
-                            bool n = (is_terminal(it->first)) ? false : (it->first == "$") ? true : _M_nullable[*it];
-                            if(!n)
-                            {
-                                found_non_nullable = true;
-                                break;
-                            }
-                        }
-                        if(found_non_nullable)
-                            _M_follow_sets[nt].insert(follow_set.begin(), follow_set.end());
-                    }
-                }
+                const auto& rhs = _M_numbered_grammar[i]._M_rhs;
+                size_t end = rhs.size();
+                while(end > 0 && _M_nullable[rhs[end - 1]])
+                    --end;
+                nullable_end[i] = end;
             }
-            //Fixed point interation
-            while(true)
+            //Each occurrence of a symbol adds the first sets of the symbols after it, up to 
+            //the first that is not nullable, and relates the symbol to the rule's left hand 
+            //side if they are all nullable
+            std::vector<std::vector<size_t>> includes(num_symbols);
+            for(size_t symbol = 0; symbol < num_symbols; ++symbol)
             {
-                bool changed = false;
-                for(const auto& nt: non_terminals)
+                auto& follow_set = _M_follow_sets[symbol];
+                if (_M_extended_symbols[symbol].first == _M_start)
+                    follow_set.set(_M_eof);
+                for(const auto& occurrence: _M_occurrences[symbol])
                 {
-                    for(const auto& rule: _M_extended_grammar)
+                    const auto& rule = _M_numbered_grammar[occurrence.first];
+                    for(size_t j = occurrence.second + 1; j < rule._M_rhs.size(); ++j)
                     {
-                        auto it = std::find(rule._M_rhs.begin(), rule._M_rhs.end(), nt);
-                        //nt is in RHS of given rule
-                        if(it != rule._M_rhs.end())
-                        {
-                            bool found_non_nullable = false;
-                            //Check if there are non-nullable symbols after non-terminal
-                            while(++it != rule._M_rhs.end())
-                            {
-                                bool n = (is_terminal(it->first)) ? false : (it->first == "$") ? true : _M_nullable[*it];
-                                if(!n)
-                                {
-                                    found_non_nullable = true;
-                                    break;
-                                }
-                            }
-                            //If no non-nullable symbols, add FOLLOW(LHS) to FOLLOW(NT)
-                            if(!found_non_nullable)
-                            {
-                                auto it2 = _M_follow_sets.find(rule._M_lhs);
-                                if (it2 != _M_follow_sets.end())
-                                {
-                                    //We can short-cut here
-                                    size_t old_size = _M_follow_sets[nt].size();
-                                    _M_follow_sets[nt].insert(it2->second.begin(), it2->second.end());
-                                    if(old_size != _M_follow_sets[nt].size())
-                                        changed = true;
-                                }
-                            }
-                        }
+                        follow_set.merge(_M_first_sets[rule._M_rhs[j]]);
+                        if (!_M_nullable[rule._M_rhs[j]])
+                            break;
                     }
+                    if (occurrence.second + 1 >= nullable_end[occurrence.first] && rule._M_lhs != symbol)
+                        includes[symbol].push_back(rule._M_lhs);
                 }
-                if(!changed)
-                    break;
             }
+            digraph(includes, _M_follow_sets);
         }
 
         automata::dfa<std::string> parser_generator::create_goto_table()
@@ -444,7 +856,7 @@ namespace final_project
                 {
                     if(!is_terminal(transition.first))
                     {
-                        dfa_row[transition.first] = static_cast<automata::state_t>(transition.second);
+                        dfa_row[_M_symbols.name(transition.first)] = static_cast<automata::state_t>(transition.second);
                     }
                 }
                 dfa_table[i] = dfa_row;
@@ -452,6 +864,121 @@ namespace final_project
             return automata::dfa<std::string>({}, dfa_table);
         }
 
+        void parser_generator::create_extended_lookaheads(const std::vector<parser_generator::item_set_t>& sets)
+        {
+            //The lookaheads of each production in the state it is reduced in, which are the 
+            //follow sets of every extended rule for the production that ends in that state
+            std::map<std::pair<size_t, size_t>, dynamic_bitset> condensed_grammar;
+            for(size_t i = 0; i < _M_extended_grammar.size(); ++i)
+            {
+                //Get final set of rule. The S rule ends in $ and is never reduced. 
+                auto final_set = _M_extended_grammar[i]._M_rhs.back().second.second;
+                if (final_set >= sets.size())
+                    continue;
+                const auto& rule = _M_numbered_grammar[i];
+                auto it = condensed_grammar.insert(std::make_pair(std::make_pair(final_set, rule._M_production), 
+                    dynamic_bitset(_M_symbols.size()))).first;
+                it->second.merge(_M_follow_sets[rule._M_lhs]);
+            }
+            _M_reductions.assign(sets.size(), {});
+            for(const auto& row: condensed_grammar)
+                _M_reductions[row.first.first].push_back({row.first.second, row.second});
+        }
+
+        void parser_generator::create_lookaheads(const std::vector<parser_generator::item_set_t>& sets)
+        {
+            create_symbol_first_sets();
+            const auto& nullable = _M_symbol_nullable;
+
+            //Number the nonterminal transitions
+            std::vector<std::pair<size_t, symbol_t>> transitions;
+            std::unordered_map<uint64_t, size_t> transition_index;
+            for(size_t state = 0; state < _M_translation_table.size(); ++state)
+            {
+                for(const auto& t: _M_translation_table[state])
+                {
+                    if (!is_terminal(t.first))
+                    {
+                        transition_index[uint64_t(state) * _M_symbols.size() + t.first] = transitions.size();
+                        transitions.push_back(std::make_pair(state, t.first));
+                    }
+                }
+            }
+
+            //The terminals read directly after each transition, and the transitions it reads
+            std::vector<dynamic_bitset> lookaheads(transitions.size(), dynamic_bitset(_M_symbols.size()));
+            std::vector<std::vector<size_t>> reads(transitions.size());
+            for(size_t i = 0; i < transitions.size(); ++i)
+            {
+                size_t target = _M_translation_table[transitions[i].first].at(transitions[i].second);
+                for(const auto& t: _M_translation_table[target])
+                {
+                    if (is_terminal(t.first))
+                        lookaheads[i].set(t.first);
+                    else if (nullable[t.first])
+                        reads[i].push_back(transition_index.at(uint64_t(target) * _M_symbols.size() + t.first));
+                }
+                //There is no transition on $, but the S rule reads it
+                for(item_t item: sets[target]._M_items)
+                {
+                    if (_M_eof != NO_SYMBOL && next_symbol(item) == _M_eof)
+                        lookaheads[i].set(_M_eof);
+                }
+            }
+            digraph(reads, lookaheads);
+
+            //Follow every production of the nonterminal of each transition from the 
+            //transition's state. The transitions on nonterminals followed only by 
+            //nullable symbols include the transition, and the state reached looks back to it.
+            std::vector<std::vector<size_t>> includes(transitions.size());
+            //The state, production, and transition of each lookback
+            std::vector<std::pair<std::pair<size_t, size_t>, size_t>> lookbacks;
+            std::vector<size_t> path;
+            for(size_t i = 0; i < transitions.size(); ++i)
+            {
+                for(size_t production = 0; production < _M_grammar.size(); ++production)
+                {
+                    const auto& rule = _M_grammar[production];
+                    if (rule._M_lhs != transitions[i].second)
+                        continue;
+                    //path[j] is the state before the jth symbol
+                    path.clear();
+                    size_t state = transitions[i].first;
+                    for(symbol_t symbol: rule._M_rhs)
+                    {
+                        //There is no transition on $, and the S rule is accepted instead of reduced
+                        if (symbol == _M_eof)
+                            break;
+                        path.push_back(state);
+                        if (symbol != _M_epsilon)
+                            state = _M_translation_table[state].at(symbol);
+                    }
+                    if (path.size() < rule._M_rhs.size())
+                        continue;
+                    lookbacks.push_back(std::make_pair(std::make_pair(state, production), i));
+                    for(size_t j = rule._M_rhs.size(); j-- > 0;)
+                    {
+                        symbol_t symbol = rule._M_rhs[j];
+                        if (symbol != _M_epsilon && !is_terminal(symbol))
+                            includes[transition_index.at(uint64_t(path[j]) * _M_symbols.size() + symbol)].push_back(i);
+                        if (!nullable[symbol])
+                            break;
+                    }
+                }
+            }
+            digraph(includes, lookaheads);
+
+            _M_reductions.assign(sets.size(), {});
+            std::sort(lookbacks.begin(), lookbacks.end());
+            for(const auto& lookback: lookbacks)
+            {
+                auto& reductions = _M_reductions[lookback.first.first];
+                if (reductions.empty() || reductions.back()._M_production != lookback.first.second)
+                    reductions.push_back({lookback.first.second, dynamic_bitset(_M_symbols.size())});
+                reductions.back()._M_lookaheads.merge(lookaheads[lookback.second]);
+            }
+        }
+
         automata::dfa<std::string> parser_generator::create_action_table(const std::vector<parser_generator::item_set_t>& sets)
         {
             automata::dfa<std::string>::table_t dfa_table(_M_translation_table.size());
@@ -465,67 +992,33 @@ namespace final_project
                 for(const auto& transition: row)
                 {
                     if(is_terminal(transition.first))
-                        dfa_row[transition.first] = static_cast<automata::state_t>(transition.second);
+                        dfa_row[_M_symbols.name(transition.first)] = static_cast<automata::state_t>(transition.second);
                 }
                 dfa_table[i] = dfa_row;
             }
-            //Add in reductions 
-            std::unordered_map<size_t, std::pair<rule_t, std::set<std::string>>> condensed_grammar;
-            for(const auto& rule: _M_extended_grammar)
-            {
-                //Get final set of rule
-                auto final_set = rule._M_rhs.back().second.second;
-                auto it = condensed_grammar.find(final_set);
-                if(it == condensed_grammar.end())
-                {  
-                    std::string lhs = rule._M_lhs.first;
-                    std::vector<std::string> rhs;
-                    std::transform(rule._M_rhs.begin(), rule._M_rhs.end(), std::back_inserter(rhs), 
-                        [](const extended_rule_t::symbol& er)
-                        {
-                            return er.first;
-                        });
-                    rule_t r = {0, lhs, rhs};
-                    auto it2 = _M_follow_sets.find(rule._M_lhs);
-                    if(it2 != _M_follow_sets.end())
-                    {
-                        auto follow_set = it2->second;
-                        condensed_grammar[final_set] = {r, follow_set};
-                    }
-                }
-                else 
-                {
-                    auto final_set = rule._M_rhs.back().second.second;
-                    auto& follow_set = it->second.second;
-                    auto it2 = _M_follow_sets.find(rule._M_lhs);
-                    if(it2 != _M_follow_sets.end())
-                    {
-                        auto set = it2->second;
-                        follow_set.insert(set.begin(), set.end());
-                    }
-                }
-            }
-            for(const auto& row: condensed_grammar)
+            //Add in reductions, the last production first so the first one is kept on a conflict
+            for(size_t state = 0; state < _M_reductions.size(); ++state)
             {
-                size_t state = row.first;
-                auto it = std::find(_M_grammar.begin(), _M_grammar.end(), row.second.first);
-                automata::state_t reduce_number = -(it-_M_grammar.begin());
-                std::unordered_map<std::string, automata::state_t> dfa_row = dfa_table[state];
-                for(const auto& symb: row.second.second)
+                auto& dfa_row = dfa_table[state];
+                for(auto it = _M_reductions[state].rbegin(); it != _M_reductions[state].rend(); ++it)
                 {
-                    dfa_row[symb] = reduce_number;
+                    automata::state_t reduce_number = -static_cast<automata::state_t>(it->_M_production);
+                    it->_M_lookaheads.for_each([&](size_t symb)
+                        {
+                            dfa_row[_M_symbols.name(symb)] = reduce_number;
+                        });
                 }
-                dfa_table[state] = dfa_row;
             }
 
             for(size_t i = 0; i < sets.size(); ++i)
             {
                 auto set = sets[i];
-                for(const auto& rule: set._M_rules)
+                for(item_t item: set._M_items)
                 {
-                    if (rule._M_lhs == "S" && rule._M_pointer == rule._M_rhs.size() - 1)
+                    const auto& rule = _M_grammar[item_production(item)];
+                    if (rule._M_lhs == _M_start && item_dot(item) == rule._M_rhs.size() - 1)
                     {
-                        dfa_table[i]["$"] = automata::ACCEPT;
+                        dfa_table[i][TP_EOF] = automata::ACCEPT;
                     }
                 }
             }
@@ -534,11 +1027,21 @@ namespace final_project
 
         std::pair<automata::dfa<std::string>, automata::dfa<std::string>> parser_generator::create_parse_tables()
         {
-            auto item_sets = create_item_sets();
-            create_translation_table(item_sets);
-            create_extended_grammar(item_sets);
-            create_first_sets();
-            create_follow_sets();
+            std::vector<item_set_t> item_sets;
+            if (_M_method == LA_PAGER_LR1 || _M_method == LA_CANONICAL_LR1)
+                item_sets = create_lr1_item_sets(_M_method == LA_PAGER_LR1);
+            else
+                item_sets = create_item_sets();
+            if (_M_method == LA_EXTENDED_GRAMMAR)
+            {
+                create_extended_grammar(item_sets);
+                compute_nullables();
+                create_first_sets();
+                create_follow_sets();
+                create_extended_lookaheads(item_sets);
+            }
+            else if (_M_method == LA_DEREMER_PENNELLO)
+                create_lookaheads(item_sets);
             auto goto_table = create_goto_table();
             auto action_table = create_action_table(item_sets);
             return std::make_pair(action_table, goto_table);
@@ -580,6 +1083,130 @@ namespace final_project
             }
             return os;
         }
+
+        //Assigns a column to every symbol that appears in the table, in sorted order
+        static std::vector<std::string> table_columns(const automata::dfa<std::string>& table)
+        {
+            std::set<std::string> symbols;
+            for(const auto& row: table.get_table())
+            {
+                for(const auto& transition: row)
+                    symbols.insert(transition.first);
+            }
+            return std::vector<std::string>(symbols.begin(), symbols.end());
+        }
+
+        parser_generator::compressed_tables_t parser_generator::compress_tables(const automata::dfa<std::string>& action, 
+                    const automata::dfa<std::string>& goto_table)
+        {
+            compressed_tables_t tables;
+            tables._M_action_columns = table_columns(action);
+            tables._M_goto_columns = table_columns(goto_table);
+            std::unordered_map<std::string, size_t> action_columns;
+            for(size_t i = 0; i < tables._M_action_columns.size(); ++i)
+                action_columns[tables._M_action_columns[i]] = i;
+            std::unordered_map<std::string, size_t> goto_columns;
+            for(size_t i = 0; i < tables._M_goto_columns.size(); ++i)
+                goto_columns[tables._M_goto_columns[i]] = i;
+
+            //Pack the actions and replace the errors of each row with its most common reduction
+            auto actions = automata::make_dense_table(action, action_columns, TP_ERROR);
+            for(auto& row: actions)
+            {
+                std::map<automata::state_t, size_t> reductions;
+                for(auto& entry: row)
+                {
+                    entry = static_cast<automata::state_t>(pack_action(entry));
+                    if (action_kind(entry) == PA_REDUCE)
+                        ++reductions[entry];
+                }
+                auto most_common = std::max_element(reductions.begin(), reductions.end(),
+                    [](const std::pair<const automata::state_t, size_t>& lhs, const std::pair<const automata::state_t, size_t>& rhs)
+                    {
+                        return lhs.second < rhs.second;
+                    });
+                if (most_common == reductions.end())
+                    continue;
+                for(auto& entry: row)
+                {
+                    if (entry == PA_ERROR)
+                        entry = most_common->first;
+                }
+            }
+            tables._M_action_rows = automata::merge_identical_rows(actions);
+            tables._M_action = automata::compress_table(actions);
+
+            //Store the gotos by nonterminal. A missing goto is never looked up, so it 
+            //takes the most common state of the nonterminal like the rest of its defaults.
+            auto gotos = automata::make_dense_table(goto_table, goto_columns, -1);
+            automata::comb_table::dense_table_t by_nonterminal(tables._M_goto_columns.size(), 
+                std::vector<automata::state_t>(gotos.size(), -1));
+            for(size_t state = 0; state < gotos.size(); ++state)
+            {
+                for(size_t column = 0; column < gotos[state].size(); ++column)
+                    by_nonterminal[column][state] = gotos[state][column];
+            }
+            for(auto& row: by_nonterminal)
+            {
+                std::map<automata::state_t, size_t> counts;
+                for(auto entry: row)
+                {
+                    if (entry != -1)
+                        ++counts[entry];
+                }
+                auto most_common = std::max_element(counts.begin(), counts.end(),
+                    [](const std::pair<const automata::state_t, size_t>& lhs, const std::pair<const automata::state_t, size_t>& rhs)
+                    {
+                        return lhs.second < rhs.second;
+                    });
+                if (most_common == counts.end())
+                    continue;
+                for(auto& entry: row)
+                {
+                    if (entry == -1)
+                        entry = most_common->first;
+                }
+            }
+            tables._M_goto_rows = automata::merge_identical_rows(by_nonterminal);
+            tables._M_goto = automata::compress_table(by_nonterminal);
+            return tables;
+        }
+
+        //Prints one compressed table and the row of each state or symbol
+        static void print_comb_vectors(std::ostream& os, const std::vector<std::string>& columns, 
+            const std::vector<automata::state_t>& rows, const automata::comb_table& table, size_t dense_size)
+        {
+            os << "Columns:";
+            for(const auto& column: columns)
+                os << " " << column;
+            const std::pair<const char*, const std::vector<automata::state_t>*> vectors[] = {
+                {"Rows", &rows}, {"Base", &table._M_base}, {"Default", &table._M_default}, {"Next", &table._M_next}, 
+                {"Check", &table._M_check}
+            };
+            for(const auto& v: vectors)
+            {
+                os << "\n" << v.first << ":";
+                for(auto value: *v.second)
+                    os << " " << value;
+            }
+            size_t size = rows.size() + table.size();
+            os << "\nCompressed to " << size << " of " << dense_size << " entries (ratio " 
+                << (size == 0 ? 1.0 : static_cast<double>(dense_size) / size) << ")\n";
+        }
+
+        std::ostream& parser_generator::print_compressed_tables(std::ostream& os, const compressed_tables_t& tables)
+        {
+            os << "Compressed GOTO Table: \n";
+            os << "One row per nonterminal, one column per state\n";
+            print_comb_vectors(os, tables._M_goto_columns, tables._M_goto_rows, tables._M_goto, 
+                tables._M_goto_columns.size() * tables._M_action_rows.size());
+            os << "\n\nCompressed Action Table: \n";
+            os << "Action = value * " << (1u << ACTION_KIND_BITS) << " + kind, where kind is Error = " << PA_ERROR 
+                << ", Shift = " << PA_SHIFT << ", Reduce = " << PA_REDUCE << ", Accept = " << PA_ACCEPT << "\n";
+            print_comb_vectors(os, tables._M_action_columns, tables._M_action_rows, tables._M_action, 
+                tables._M_action_columns.size() * tables._M_action_rows.size());
+            return os;
+        }
     } // namespace parser
     
 } // namespace final_project
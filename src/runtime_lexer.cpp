@@ -0,0 +1,170 @@
+#include "lexer/runtime_lexer.hh"
+#include "lexer/lexer_generator.hh"
+#include "automata/comb_table.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <set>
+
+namespace final_project
+{
+    namespace lexer
+    {
+        runtime_lexer::runtime_lexer(std::istream& spec, bool jit)
+            : runtime_lexer(build_dfa(spec), jit)
+        {
+
+        }
+
+        runtime_lexer::runtime_lexer(const automata::dfa<char>& d, bool jit)
+            : _M_names(), _M_classes(256, 0), _M_num_classes(0), _M_next(), _M_accept(), _M_jit(), _M_scan(nullptr)
+        {
+            //Number the token types like the enum of a generated lexer
+            const auto& labels = d.get_accepting_labels();
+            const auto& accepting_states = d.get_accepting_states();
+            std::set<std::string> tokens;
+            for(const auto& label: labels)
+                tokens.insert(label.second);
+            _M_names.assign(tokens.begin(), tokens.end());
+            _M_names.push_back("EOF");
+            _M_names.push_back("ERROR");
+
+            auto dense = automata::make_dense_table(d, -1);
+            //A generated lexer ends a token on whitespace before it looks at the
+            //transitions, which is the same as whitespace having none
+            for(auto& row: dense)
+            {
+                for(int c = 0; c < 256; ++c)
+                {
+                    if (isspace(c))
+                        row[c] = -1;
+                }
+            }
+
+            //Characters with the same column in every state share a class
+            std::map<std::vector<automata::state_t>, uint8_t> columns;
+            std::vector<size_t> representative;
+            for(int c = 0; c < 256; ++c)
+            {
+                std::vector<automata::state_t> column(dense.size());
+                for(size_t state = 0; state < dense.size(); ++state)
+                    column[state] = dense[state][c];
+                auto it = columns.find(column);
+                if (it == columns.end())
+                {
+                    it = columns.insert(std::make_pair(column, static_cast<uint8_t>(representative.size()))).first;
+                    representative.push_back(c);
+                }
+                _M_classes[c] = it->second;
+            }
+            _M_num_classes = representative.size();
+
+            _M_next.assign(dense.size() * _M_num_classes, -1);
+            _M_accept.assign(dense.size(), error_type());
+            for(size_t state = 0; state < dense.size(); ++state)
+            {
+                for(size_t cls = 0; cls < _M_num_classes; ++cls)
+                {
+                    automata::state_t next = dense[state][representative[cls]];
+                    if (next >= 0)
+                        _M_next[state * _M_num_classes + cls] = static_cast<int32_t>(next * _M_num_classes);
+                }
+                auto label = labels.find(static_cast<automata::state_t>(state));
+                if (label != labels.end() && std::find(accepting_states.begin(), accepting_states.end(),
+                        static_cast<automata::state_t>(state)) != accepting_states.end())
+                    _M_accept[state] = std::lower_bound(_M_names.begin(), _M_names.end() - 2, label->second) - _M_names.begin();
+            }
+
+            if (jit)
+            {
+                _M_jit = std::make_shared<lexer_jit>(_M_next, _M_classes, _M_num_classes);
+                _M_scan = _M_jit->function();
+            }
+        }
+
+        const std::vector<std::string>& runtime_lexer::token_names() const
+        {
+            return _M_names;
+        }
+
+        size_t runtime_lexer::eof_type() const
+        {
+            return _M_names.size() - 2;
+        }
+
+        size_t runtime_lexer::error_type() const
+        {
+            return _M_names.size() - 1;
+        }
+
+        size_t runtime_lexer::num_classes() const
+        {
+            return _M_num_classes;
+        }
+
+        bool runtime_lexer::is_jit() const
+        {
+            return _M_scan != nullptr;
+        }
+
+        runtime_lexer::token_t runtime_lexer::next_token(const char* data, size_t length, size_t& pos) const
+        {
+            while(isspace(static_cast<unsigned char>(data[pos])))
+                ++pos;
+            token_t tok;
+            tok._M_offset = pos;
+            if (pos >= length)
+            {
+                tok._M_length = 0;
+                tok._M_type = eof_type();
+                return tok;
+            }
+            //There is no transition on NUL, so the sentinel after the input stops the loop
+            if (_M_scan)
+            {
+                int32_t state;
+                pos = _M_scan(data + pos, &state) - data;
+                tok._M_type = _M_accept[state];
+            }
+            else
+            {
+                const int32_t* next = _M_next.data();
+                const uint8_t* classes = _M_classes.data();
+                int32_t row = 0;
+                while(true)
+                {
+                    int32_t n = next[row + classes[static_cast<unsigned char>(data[pos])]];
+                    if (n < 0)
+                        break;
+                    row = n;
+                    ++pos;
+                }
+                tok._M_type = _M_accept[row / _M_num_classes];
+            }
+            //A character that cannot be matched is part of the error token
+            if (tok._M_type == error_type() && pos < length)
+                ++pos;
+            tok._M_length = pos - tok._M_offset;
+            return tok;
+        }
+
+        runtime_lexer::token_t runtime_lexer::next_token(const std::string& text, size_t& pos) const
+        {
+            return next_token(text.data(), text.length(), pos);
+        }
+
+        std::vector<runtime_lexer::token_t> runtime_lexer::tokenize(const std::string& text) const
+        {
+            std::vector<token_t> tokens;
+            size_t pos = 0;
+            while(true)
+            {
+                tokens.push_back(next_token(text, pos));
+                if (tokens.back()._M_type == eof_type())
+                    return tokens;
+            }
+        }
+    } // namespace lexer
+
+} // namespace final_project
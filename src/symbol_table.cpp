@@ -0,0 +1,34 @@
+#include "parser/symbol_table.hh"
+
+namespace final_project
+{
+    namespace parser
+    {
+        symbol_t symbol_table::intern(const std::string& name)
+        {
+            auto it = _M_ids.find(name);
+            if (it != _M_ids.end())
+                return it->second;
+            symbol_t id = static_cast<symbol_t>(_M_names.size());
+            _M_names.push_back(name);
+            _M_ids.insert(std::make_pair(name, id));
+            return id;
+        }
+
+        symbol_t symbol_table::find(const std::string& name) const
+        {
+            auto it = _M_ids.find(name);
+            return (it == _M_ids.end()) ? NO_SYMBOL : it->second;
+        }
+
+        const std::string& symbol_table::name(symbol_t symbol) const
+        {
+            return _M_names[symbol];
+        }
+
+        size_t symbol_table::size() const
+        {
+            return _M_names.size();
+        }
+    } // namespace parser
+} // namespace final_project
@@ -1,8 +1,55 @@
 #include "lexer.hh"
 #include <iostream>
+#include <fstream>
+
+//Prints one token per line
+void print_tokens(lexer::lexer& l)
+{
+    while (true)
+    {
+        auto tok = l.next_token();
+        if (tok._M_type == lexer::token_type::tl_EOF)
+            break;
+        if (tok._M_type == lexer::token_type::tl_ERROR)
+            std::cout << "ERROR: ";
+        std::cout << l.text(tok) << "\n";
+    }
+}
+
+//Lexes a whole file in place (or in chunks with --stream) and prints one token per line
+int lex_file(const char* filename, bool stream)
+{
+    if (stream)
+    {
+        std::ifstream fin(filename, std::ios::binary);
+        if (!fin.is_open())
+        {
+            std::cout << "Could not open " << filename << std::endl;
+            return 1;
+        }
+        lexer::lexer l(fin);
+        print_tokens(l);
+        return 0;
+    }
+    try
+    {
+        lexer::lexer l = lexer::lexer::from_file(filename);
+        print_tokens(l);
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
 
 int main(int argc, char** argv)
 {
+    if (argc > 2 && std::string(argv[1]) == "--stream")
+        return lex_file(argv[2], true);
+    if (argc > 1)
+        return lex_file(argv[1], false);
     std::string l;
     while (true) {
         std::cout << "Enter text to lexer or type Q to quit: \n";
@@ -15,9 +62,11 @@ int main(int argc, char** argv)
         for(auto tok: tokens)
         {
             if(tok._M_type == lexer::token_type::tl_ERROR)
-                std::cout << "ERROR: " <<tok._M_val << " ";
+                std::cout << "ERROR: " << l.text(tok) << " ";
+            else if(tok._M_type == lexer::token_type::tl_EOF)
+                std::cout << "$ ";
             else
-                std::cout << tok._M_val << " ";
+                std::cout << l.text(tok) << " ";
         }
         std::cout << std::endl << std::endl;
     }
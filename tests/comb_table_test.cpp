@@ -0,0 +1,143 @@
+#include "unit_test_framework.hh"
+
+#include "automata/comb_table.hh"
+#include "automata/dfa.hh"
+#include "automata/nfa.hh"
+#include "automata/regex_parser.hh"
+
+#include <sstream>
+#include <cstdlib>
+
+using namespace final_project::automata;
+using namespace final_project::regex;
+
+#define CREATE_DFA(exp)\
+    std::string regex = exp;\
+    std::istringstream str_in(regex);\
+    regex_parser parser(str_in);\
+    auto parsed = parser.parse();\
+    nfa n = final_project::automata::build_nfa(parsed);\
+    dfa<char> d = powerset_construction(n);
+
+//Expands a compressed table back into a dense table
+comb_table::dense_table_t expand(const comb_table& table)
+{
+    comb_table::dense_table_t dense(table._M_base.size(), std::vector<state_t>(table._M_columns));
+    for(size_t i = 0; i < dense.size(); ++i)
+    {
+        for(size_t j = 0; j < table._M_columns; ++j)
+            dense[i][j] = table.lookup(static_cast<state_t>(i), j);
+    }
+    return dense;
+}
+
+//Compares two dense tables row by row
+#define TABLE_CHECK(expected, actual)\
+    if(expected.size() != actual.size())\
+        passed = -1;\
+    for(size_t row = 0; row < std::min(expected.size(), actual.size()); ++row)\
+    {\
+        CONTENT_CHECK(expected[row], actual[row])\
+    }
+
+TESTING_SETUP()
+
+BEGIN_TEST(Comb_Table_Empty_Rows, Compress a table where every row is its default)
+    passed = 1;
+    comb_table::dense_table_t dense = {
+        {-1, -1, -1},
+        {-1, -1, -1}
+    };
+    comb_table table = compress_table(dense);
+    auto expanded = expand(table);
+    TABLE_CHECK(dense, expanded)
+    CONTENT_CHECK(std::vector<state_t>({-1, -1}), table._M_default)
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Comb_Table_Overlap, Rows with disjoint columns share slots)
+    passed = 1;
+    comb_table::dense_table_t dense = {
+        {1, -1, -1, -1, -1},
+        {-1, 2, -1, -1, -1},
+        {-1, -1, 3, -1, -1},
+        {-1, -1, -1, 4, 4}
+    };
+    comb_table table = compress_table(dense);
+    auto expanded = expand(table);
+    TABLE_CHECK(dense, expanded)
+    //All rows fit in the first five slots plus padding
+    if (table._M_next.size() > 2 * table._M_columns)
+        passed = -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Comb_Table_Random, Compress and expand random sparse tables)
+    passed = 1;
+    std::srand(552);
+    for(int trial = 0; trial < 20; ++trial)
+    {
+        comb_table::dense_table_t dense(50, std::vector<state_t>(40, -1));
+        for(auto& row: dense)
+        {
+            for(auto& entry: row)
+            {
+                if (std::rand() % 8 == 0)
+                    entry = std::rand() % 50;
+            }
+        }
+        comb_table table = compress_table(dense);
+        auto expanded = expand(table);
+        TABLE_CHECK(dense, expanded)
+    }
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Comb_Table_Defaults, Compress with a specified default for each row)
+    passed = 1;
+    comb_table::dense_table_t dense = {
+        {5, -1, 5, 5},
+        {-1, -1, 7, -1}
+    };
+    comb_table table = compress_table(dense, {5, 7});
+    auto expanded = expand(table);
+    TABLE_CHECK(dense, expanded)
+    CONTENT_CHECK(std::vector<state_t>({5, 7}), table._M_default)
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Comb_Table_Merge_Rows, Remove rows that repeat an earlier row)
+    passed = 1;
+    comb_table::dense_table_t dense = {
+        {1, -1, 2},
+        {-1, 3, -1},
+        {1, -1, 2},
+        {-1, 3, -1},
+        {4, 4, 4}
+    };
+    auto original = dense;
+    auto rows = merge_identical_rows(dense);
+    CONTENT_CHECK(std::vector<state_t>({0, 1, 0, 1, 2}), rows)
+    if (dense.size() != 3)
+        passed = -1;
+    for(size_t row = 0; row < std::min(original.size(), rows.size()); ++row)
+    {
+        CONTENT_CHECK(original[row], dense[rows[row]])
+    }
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Comb_Table_DFA, Compress the transition table of a DFA)
+    passed = 1;
+    CREATE_DFA("int: (0|1|2|3|4|5|6|7|8|9)(0|1|2|3|4|5|6|7|8|9)*\nplus: +")
+    auto dense = make_dense_table(d, -1);
+    comb_table table = compress_table(dense);
+    auto expanded = expand(table);
+    TABLE_CHECK(dense, expanded)
+    std::cout << "Compression ratio: " << table.compression_ratio() << std::endl;
+    if (table.compression_ratio() <= 1.0)
+        passed = -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+TEST_MAIN()
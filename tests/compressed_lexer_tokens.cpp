@@ -0,0 +1,22 @@
+#include "lexer.hh"
+
+#include <string>
+#include <vector>
+
+//Built with lexer defined as compressed_lexer, so that the lexer generated with 
+//compressed tables does not clash with the goto lexer generated_lexer_test links.
+
+//Returns the type, offset, and length of every token the compressed lexer finds 
+//in the text as one vector, the EOF token included
+std::vector<size_t> compressed_tokens(const std::string& text)
+{
+    lexer::lexer l(text);
+    std::vector<size_t> flat;
+    for(const auto& tok: l.tokenize())
+    {
+        flat.push_back(static_cast<size_t>(tok._M_type));
+        flat.push_back(tok._M_offset);
+        flat.push_back(tok._M_length);
+    }
+    return flat;
+}
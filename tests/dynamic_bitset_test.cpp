@@ -0,0 +1,51 @@
+#include "unit_test_framework.hh"
+
+#include "parser/dynamic_bitset.hh"
+
+using namespace final_project::parser;
+
+//Returns the elements of the set in increasing order
+std::vector<size_t> elements(const dynamic_bitset& bits)
+{
+    std::vector<size_t> result;
+    bits.for_each([&](size_t i)
+        {
+            result.push_back(i);
+        });
+    return result;
+}
+
+TESTING_SETUP()
+
+BEGIN_TEST(Dynamic_Bitset_Elements, Elements are visited in order across words)
+    passed = 1;
+    dynamic_bitset bits(130);
+    bits.set(129);
+    bits.set(0);
+    bits.set(64);
+    bits.set(63);
+    bits.set(5);
+    bits.reset(5);
+    CONTENT_CHECK(std::vector<size_t>({0, 63, 64, 129}), elements(bits))
+    if (bits.count() != 4 || !bits.test(63) || bits.test(62))
+        passed = -1;
+    if (bits.next(1) != 63 || bits.next(65) != 129 || bits.next(130) != 130)
+        passed = -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Dynamic_Bitset_Merge, Merging reports whether an element was added)
+    passed = 1;
+    dynamic_bitset a(100), b(100);
+    a.set(3);
+    b.set(3);
+    b.set(70);
+    if (!a.merge(b) || a.merge(b) || a != b)
+        passed = -1;
+    a.clear();
+    if (!a.none() || a.next(0) != 100)
+        passed = -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+TEST_MAIN()
@@ -0,0 +1,22 @@
+#include "lexer/lexer_generator.hh"
+
+#include <iostream>
+#include <string>
+
+//Generates lexer.hh and lexer.cpp in the current directory from the regular
+//expressions in the file named on the command line, with compressed tables if
+//the second argument is --compress. The build runs it to make the lexers that
+//generated_lexer_test drives; the skeletons have to be copied into the
+//directory first.
+int main(int argc, char** argv)
+{
+    if (argc < 2 || (argc > 2 && std::string(argv[2]) != "--compress"))
+    {
+        std::cout << "Usage: generate_test_lexer <file with regular expressions> [--compress]" << std::endl;
+        return 1;
+    }
+    final_project::lexer::lexer_options options;
+    options._M_compress_tables = argc > 2;
+    final_project::lexer::generate_lexer(argv[1], options);
+    return 0;
+}
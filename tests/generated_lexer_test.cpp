@@ -0,0 +1,328 @@
+#include "unit_test_framework.hh"
+
+#include "lexer.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+//Drives the lexer generated from generated_lexer_regex.txt. Every way of lexing 
+//the input is checked against a plain tokenize() of the same text, with buffers and 
+//chunks small enough that tokens are split across them.
+
+//Returns the type, offset, and length of every token as one vector
+std::vector<size_t> flatten(const std::vector<lexer::token_t>& tokens)
+{
+    std::vector<size_t> flat;
+    for(const auto& tok: tokens)
+    {
+        flat.push_back(static_cast<size_t>(tok._M_type));
+        flat.push_back(tok._M_offset);
+        flat.push_back(tok._M_length);
+    }
+    return flat;
+}
+
+//The tokens the lexer generated with compressed tables finds in the text, as 
+//flatten returns them, from compressed_lexer_tokens.cpp
+std::vector<size_t> compressed_tokens(const std::string& text);
+
+//The tokens of a plain tokenize() of the text, the EOF token included
+std::vector<lexer::token_t> expected_tokens(const std::string& text)
+{
+    lexer::lexer l(text);
+    return l.tokenize();
+}
+
+//A small linear congruential generator, so the text is the same on every platform
+size_t random_number(size_t& state, size_t bound)
+{
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (state >> 33) % bound;
+}
+
+//Arithmetic with runs of whitespace and newlines, the odd character no rule
+//matches, and numbers longer than a vector register
+std::string sample_text(size_t seed, size_t length)
+{
+    const char* operators = "+-*/%";
+    const char* spaces[] = {" ", "  ", "\n", " \t", "\n\n   "};
+    std::string text;
+    while(text.length() < length)
+    {
+        size_t kind = random_number(seed, 10);
+        if (kind < 5)
+        {
+            size_t digits = (kind == 0) ? 40 + random_number(seed, 40) : 1 + random_number(seed, 6);
+            for(size_t i = 0; i < digits; ++i)
+                text += static_cast<char>('0' + random_number(seed, 10));
+        }
+        else if (kind < 9)
+            text += operators[random_number(seed, 5)];
+        else
+            text += 'x';
+        if (random_number(seed, 4) != 0)
+            text += spaces[random_number(seed, 5)];
+    }
+    return text;
+}
+
+//The line and column of an offset, found by scanning the text
+lexer::position_t expected_position(const std::string& text, lexer::index_t offset)
+{
+    lexer::position_t pos = {0, 0};
+    for(lexer::index_t i = 0; i < offset; ++i)
+    {
+        if (text[i] == '\n')
+        {
+            ++pos._M_line;
+            pos._M_col = 0;
+        }
+        else
+            ++pos._M_col;
+    }
+    return pos;
+}
+
+//Applies an edit with relex and checks the tokens and their text against
+//a plain tokenize() of the edited text
+bool check_relex(lexer::lexer& l, std::vector<lexer::token_t>& tokens, std::string& text,
+    lexer::index_t offset, lexer::index_t deleted, const std::string& inserted)
+{
+    std::vector<lexer::token_t> old_tokens = tokens;
+    lexer::splice_t splice = l.relex(tokens, offset, deleted, inserted);
+    text.replace(offset, deleted, inserted);
+    if (flatten(tokens) != flatten(expected_tokens(text)))
+    {
+        std::cout << "relex(" << offset << ", " << deleted << ", \"" << inserted << "\") differs from tokenize" << std::endl;
+        return false;
+    }
+    //Only the spliced tokens are new
+    if (splice._M_first + splice._M_inserted + (old_tokens.size() - splice._M_first - splice._M_removed) != tokens.size())
+        return false;
+    for(size_t i = 0; i < splice._M_first; ++i)
+    {
+        if (tokens[i]._M_offset != old_tokens[i]._M_offset || tokens[i]._M_length != old_tokens[i]._M_length)
+            return false;
+    }
+    for(const auto& tok: tokens)
+    {
+        if (l.text(tok) != text.substr(tok._M_offset, tok._M_length))
+            return false;
+    }
+    return true;
+}
+
+TESTING_SETUP()
+
+BEGIN_TEST(Streamed_Tokens, Streamed input lexes like in-memory input across buffer boundaries)
+    passed = 1;
+    std::string text = sample_text(1, 5000);
+    auto expected = flatten(expected_tokens(text));
+    for(size_t buffer_size: {1, 2, 3, 7, 16, 100, 4096})
+    {
+        std::istringstream in(text);
+        lexer::lexer l(in, buffer_size);
+        std::vector<lexer::token_t> tokens;
+        while(true)
+        {
+            lexer::token_t tok = l.next_token();
+            //The text of a streamed token is only valid until the next token
+            if (l.text(tok) != text.substr(tok._M_offset, tok._M_length))
+                passed = -1;
+            tokens.push_back(tok);
+            if (tok._M_type == lexer::token_type::tl_EOF)
+                break;
+        }
+        auto actual = flatten(tokens);
+        CONTENT_CHECK(expected, actual)
+    }
+    //A source that returns fewer characters than it is asked for
+    size_t next = 0;
+    size_t seed = 2;
+    lexer::lexer l([&](char* buffer, size_t size) -> size_t
+        {
+            size_t n = std::min(std::min(size, 1 + random_number(seed, 5)), text.length() - next);
+            text.copy(buffer, n, next);
+            next += n;
+            return n;
+        }, 8);
+    auto actual = flatten(l.tokenize());
+    CONTENT_CHECK(expected, actual)
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Batched_Tokens, next_tokens fills the arrays with the tokens tokenize returns)
+    passed = 1;
+    std::string text = sample_text(3, 5000);
+    auto expected_with_eof = expected_tokens(text);
+    auto expected = flatten(std::vector<lexer::token_t>(expected_with_eof.begin(), expected_with_eof.end() - 1));
+    for(size_t capacity: {1, 5, 64})
+    {
+        for(bool streamed: {false, true})
+        {
+            std::istringstream in(text);
+            lexer::lexer l = streamed ? lexer::lexer(in, 7) : lexer::lexer(text);
+            std::vector<uint16_t> types(capacity);
+            std::vector<uint32_t> offsets(capacity), lengths(capacity);
+            std::vector<size_t> actual;
+            lexer::index_t base = 0;
+            while(size_t n = l.next_tokens(types.data(), offsets.data(), lengths.data(), capacity, base))
+            {
+                for(size_t j = 0; j < n; ++j)
+                {
+                    actual.push_back(types[j]);
+                    actual.push_back(base + offsets[j]);
+                    actual.push_back(lengths[j]);
+                }
+            }
+            CONTENT_CHECK(expected, actual)
+        }
+    }
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Parallel_Tokens, tokenize_parallel stitches the chunks into the tokens tokenize returns)
+    passed = 1;
+    std::vector<std::string> texts = {sample_text(4, 5000), "", "   ", "1+2", " 12 34\n56 ",
+        std::string(300, '7') + " " + std::string(5, '8'), "x x x x x x x x x"};
+    for(const auto& text: texts)
+    {
+        auto expected = flatten(expected_tokens(text));
+        for(size_t threads: {2, 3, 4, 7, 16})
+        {
+            for(lexer::index_t min_chunk: {1, 5, 64})
+            {
+                lexer::lexer l(text);
+                auto actual = flatten(l.tokenize_parallel(threads, min_chunk));
+                CONTENT_CHECK(expected, actual)
+            }
+        }
+    }
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Positions, Lines and columns from the newline index match a scan of the text)
+    passed = 1;
+    std::string text = sample_text(5, 5000);
+    auto tokens = expected_tokens(text);
+    //Ask for the last positions first, then for ones already indexed
+    lexer::lexer backwards(text);
+    for(auto it = tokens.rbegin(); it != tokens.rend(); ++it)
+    {
+        lexer::position_t actual = backwards.position(*it);
+        lexer::position_t expected = expected_position(text, it->_M_offset);
+        if (actual._M_line != expected._M_line || actual._M_col != expected._M_col)
+            passed = -1;
+    }
+    //The newlines of streamed input are indexed before its buffer is discarded
+    std::istringstream in(text);
+    lexer::lexer streamed(in, 5);
+    while(true)
+    {
+        lexer::token_t tok = streamed.next_token();
+        lexer::position_t actual = streamed.position(tok);
+        lexer::position_t expected = expected_position(text, tok._M_offset);
+        if (actual._M_line != expected._M_line || actual._M_col != expected._M_col)
+            passed = -1;
+        if (tok._M_type == lexer::token_type::tl_EOF)
+            break;
+    }
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Relex, relex updates the tokens of an edit like a fresh tokenize)
+    passed = 1;
+    const std::string base = "12 + 345 * 6\n- 78 / 9 % 10";
+    struct edit_t
+    {
+        lexer::index_t _M_offset;
+        lexer::index_t _M_deleted;
+        std::string _M_inserted;
+    };
+    std::vector<edit_t> edits = {
+        {6, 0, "0"},        //Inside a token
+        {6, 1, "9"},        //Replace a character of a token
+        {2, 0, "3"},        //At the end of a token, which it continues
+        {3, 0, "7"},        //At the start of a token
+        {2, 1, ""},         //Delete the whitespace between two tokens
+        {0, 0, "+"},        //At the start of the input
+        {6, 10, ""},        //Delete from inside one token to inside another
+        {5, 12, "x 1"},     //Replace several tokens
+        {26, 0, " 11 + 2"}, //At the end of the input
+        {26, 0, "0"},       //Continue the last token
+    };
+    for(const auto& edit: edits)
+    {
+        std::string text = base;
+        lexer::lexer l(text);
+        auto tokens = l.tokenize();
+        if (!check_relex(l, tokens, text, edit._M_offset, edit._M_deleted, edit._M_inserted))
+            passed = -1;
+    }
+    //A sequence of random edits of the same tokens
+    std::string text = sample_text(6, 2000);
+    lexer::lexer l(text);
+    auto tokens = l.tokenize();
+    size_t seed = 7;
+    const std::string alphabet = "0123456789+-*x \n";
+    for(size_t i = 0; i < 300 && passed != -1; ++i)
+    {
+        lexer::index_t offset = random_number(seed, text.length() + 1);
+        lexer::index_t deleted = random_number(seed, std::min<size_t>(text.length() - offset, 12) + 1);
+        std::string inserted;
+        for(size_t j = random_number(seed, 6); j > 0; --j)
+            inserted += alphabet[random_number(seed, alphabet.length())];
+        if (!check_relex(l, tokens, text, offset, deleted, inserted))
+            passed = -1;
+    }
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Relex_Mapped_File, relex copies a mapped file before editing it)
+    passed = 1;
+    const char* path = "generated_lexer_test_input.txt";
+    const std::string original_text = sample_text(8, 3000);
+    std::string text = original_text;
+    {
+        std::ofstream fout(path, std::ios::binary);
+        fout << text;
+    }
+    {
+        lexer::lexer l = lexer::lexer::from_file(path);
+        auto tokens = l.tokenize();
+        auto expected = flatten(expected_tokens(text));
+        auto actual = flatten(tokens);
+        CONTENT_CHECK(expected, actual)
+        if (!check_relex(l, tokens, text, 100, 20, "1 + 2\n") || !check_relex(l, tokens, text, text.length(), 0, " 3"))
+            passed = -1;
+        //The file itself is unchanged
+        lexer::lexer original = lexer::lexer::from_file(path);
+        auto original_expected = flatten(expected_tokens(original_text));
+        auto original_actual = flatten(original.tokenize());
+        CONTENT_CHECK(original_expected, original_actual)
+    }
+    std::remove(path);
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Compressed_Tables, The lexer with compressed tables finds the tokens of the goto lexer)
+    passed = 1;
+    std::vector<std::string> texts = {sample_text(9, 5000), "~\t~", "~ ~", "~\t", "~\t~~\t~ 12", "1\t+~\t~x"};
+    //Whitespace in and around the token with a tab in it
+    const std::string alphabet = "~~\t 1+x";
+    size_t seed = 10;
+    std::string text;
+    for(size_t i = 0; i < 2000; ++i)
+        text += alphabet[random_number(seed, alphabet.length())];
+    texts.push_back(text);
+    for(const auto& text: texts)
+    {
+        auto expected = flatten(expected_tokens(text));
+        auto actual = compressed_tokens(text);
+        CONTENT_CHECK(expected, actual)
+    }
+    PASS_OR_FAIL()
+END_TEST()
+
+TEST_MAIN()
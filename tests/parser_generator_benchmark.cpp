@@ -0,0 +1,86 @@
+#ifdef DEBUG
+
+#include "parser/parser_generator.hh"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace final_project::parser;
+
+//Times the steps of the extended grammar lookahead method on a synthetic grammar
+//with 5,000 productions. The nonterminals come in blocks of ten, and a production
+//only starts with a nonterminal of its own block, so closures stay small while the
+//rest of the grammar is referred to after a terminal.
+
+const size_t NUM_NONTERMINALS = 1000;
+const size_t NUM_TERMINALS = 50;
+const size_t BLOCK_SIZE = 10;
+
+//A small linear congruential generator, so the grammar is the same on every platform
+size_t random_number(size_t& state, size_t bound)
+{
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (state >> 33) % bound;
+}
+
+std::string synthetic_grammar()
+{
+    size_t state = 552;
+    std::ostringstream os;
+    os << "terminals:";
+    for(size_t i = 0; i < NUM_TERMINALS; ++i)
+        os << " t" << i;
+    os << "\nS -> N0\n";
+    auto t = [&]()
+        {
+            return "t" + std::to_string(random_number(state, NUM_TERMINALS));
+        };
+    auto n = [&]()
+        {
+            return "N" + std::to_string(random_number(state, NUM_NONTERMINALS));
+        };
+    for(size_t i = 0; i < NUM_NONTERMINALS; ++i)
+    {
+        std::string lhs = "N" + std::to_string(i);
+        //The next nonterminal of the block, or a terminal at the end of the block
+        std::string next = (i % BLOCK_SIZE == BLOCK_SIZE - 1) ? t() : "N" + std::to_string(i + 1);
+        //The terminal that most of the nonterminal's productions start with
+        std::string own = "t" + std::to_string(i % NUM_TERMINALS);
+        os << lhs << " -> " << own << " " << n() << " " << t() << "\n";
+        os << lhs << " -> " << next << " " << t() << "\n";
+        os << lhs << " -> " << own << " " << t() << " " << n() << "\n";
+        os << lhs << " -> " << t() << " " << t() << "\n";
+        if (i % 7 == 0)
+            os << lhs << " ->\n";
+        else
+            os << lhs << " -> " << own << "\n";
+    }
+    return os.str();
+}
+
+template<class _Function>
+void time(const char* name, _Function f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    std::cout << name << ": " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+}
+
+int main()
+{
+    std::istringstream in(synthetic_grammar());
+    parser_generator p(in, parser_generator::LA_EXTENDED_GRAMMAR);
+    std::cout << p.get_grammar().size() << " productions" << std::endl;
+    std::vector<parser_generator::item_set_t> item_sets;
+    time("Item sets", [&]() { item_sets = p.create_item_sets(); });
+    std::cout << item_sets.size() << " states" << std::endl;
+    time("Extended grammar", [&]() { p.create_extended_grammar(item_sets); });
+    std::cout << p._M_extended_grammar.size() << " extended rules" << std::endl;
+    time("Nullable symbols", [&]() { p.compute_nullables(); });
+    time("First sets", [&]() { p.create_first_sets(); });
+    time("Follow sets", [&]() { p.create_follow_sets(); });
+}
+
+#endif
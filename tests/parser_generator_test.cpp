@@ -3,7 +3,9 @@
 #include "unit_test_framework.hh"
 #include "parser/parser_generator.hh"
 #include <fstream>
+#include <sstream>
 #include <iostream>
+#include <map>
 
 TESTING_SETUP()
 
@@ -15,19 +17,47 @@ using namespace final_project::parser;
 //because it is very hard to write test case 
 //solutions be hand. 
 
-std::ostream& operator<<(std::ostream& os, const parser_generator::rule_t& r)
+//The names of the symbols of the grammar being printed
+const symbol_table* symbols = nullptr;
+
+//The grammars of test_grammar.txt and test_grammar2.txt, so the tests do not 
+//depend on the directory they are run from
+const char* test_grammar = "terminals: x = *\n"
+    "S -> N\n"
+    "N -> V = E\n"
+    "N -> E\n"
+    "E -> V\n"
+    "V -> x\n"
+    "V -> * E\n";
+
+const char* test_grammar2 = "terminals: + * num\n"
+    "S -> E\n"
+    "E -> T\n"
+    "T -> E + T\n"
+    "T -> F\n"
+    "T -> M * F\n"
+    "F -> num\n"
+    "F -> ( E )\n";
+
+//Prints a production with a dot before the symbol at position dot
+void print_rule(std::ostream& os, const parser_generator::rule_t& r, size_t dot)
 {
-    os << r._M_lhs;
+    os << symbols->name(r._M_lhs);
     os << "->";
     for(size_t i = 0; i < r._M_rhs.size(); ++i)
     {
-        if (i == r._M_pointer)
+        if (i == dot)
             os << ". ";
-        os << r._M_rhs[i] << " ";
+        os << symbols->name(r._M_rhs[i]) << " ";
     }
 
-    if(r._M_pointer == r._M_rhs.size())
+    if(dot == r._M_rhs.size())
         os << ".";
+}
+
+std::ostream& operator<<(std::ostream& os, const parser_generator::rule_t& r)
+{
+    print_rule(os, r, r._M_rhs.size() + 1);
     return os;
 }
 
@@ -39,7 +69,7 @@ std::ostream& operator<<(std::ostream& os, const final_project::parser::parser_g
         os << "\t";
         for(const auto& state: row)
         {
-            std::string c = state.first;
+            std::string c = symbols->name(state.first);
             os << "{" << c << ", {";
             os << state.second << "}} ";
         }
@@ -51,11 +81,11 @@ std::ostream& operator<<(std::ostream& os, const final_project::parser::parser_g
 std::ostream& operator<<(std::ostream& os, const final_project::parser::parser_generator::extended_rule_t& r)
 {
     auto lhs = r._M_lhs;
-    os << lhs.second.first << lhs.first << lhs.second.second;
+    os << lhs.second.first << symbols->name(lhs.first) << lhs.second.second;
     os << "->";
     for(const auto& s: r._M_rhs)
     {
-        os << s.second.first << "_" << s.first << "_" << s.second.second << " ";
+        os << s.second.first << "_" << symbols->name(s.first) << "_" << s.second.second << " ";
     }
     return os;
 }
@@ -83,8 +113,9 @@ void print_action_table(const final_project::automata::dfa<std::string>& dfa)
 }
 
 BEGIN_TEST(Grammar_Parser, Test grammar parser)
-    std::ifstream fin("C:\\Users\\aschi\\Dropbox\\AERO 552\\Final Project\\tests\\test_grammar.txt");
+    std::istringstream fin(test_grammar);
     parser_generator p(fin);
+    symbols = &p.get_symbols();
     auto grammar = p.get_grammar();
     for(auto rule: grammar)
     {
@@ -95,33 +126,44 @@ BEGIN_TEST(Grammar_Parser, Test grammar parser)
 END_TEST()
 
 BEGIN_TEST(Item_Sets, Test making item sets)
-    std::ifstream fin("C:\\Users\\aschi\\Dropbox\\AERO 552\\Final Project\\tests\\test_grammar.txt");
+    std::istringstream fin(test_grammar);
     parser_generator p(fin);
+    symbols = &p.get_symbols();
     auto item_sets = p.create_item_sets();
     int curr_set = 0;
     for(const auto& set: item_sets)
     {
         std::cout << "Set I" << curr_set << std::endl;
-        for(const auto& rule: set._M_rules)
-            std::cout << "\t" << rule << std::endl;
+        for(auto item: set._M_items)
+        {
+            std::cout << "\t";
+            print_rule(std::cout, p.get_grammar()[parser_generator::item_production(item)], 
+                parser_generator::item_dot(item));
+            std::cout << std::endl;
+        }
         std::cout << std::endl;
         ++curr_set;
     }
 END_TEST()
 
 BEGIN_TEST(Translation_Table, Test making translation table)
-    std::ifstream fin("C:\\Users\\aschi\\Dropbox\\AERO 552\\Final Project\\tests\\test_grammar.txt");
+    std::istringstream fin(test_grammar);
     parser_generator p(fin);
+    symbols = &p.get_symbols();
     auto item_sets = p.create_item_sets();
-    p.create_translation_table(item_sets);
     std::cout << p._M_translation_table << std::endl;
+    //The table recorded while creating the item sets is the one found from the sets
+    auto table = p._M_translation_table;
+    p.create_translation_table(item_sets);
+    passed = table == p._M_translation_table ? 1 : -1;
+    PASS_OR_FAIL()
 END_TEST()
 
 BEGIN_TEST(Extended_Grammar, Test extended grammar)
-    std::ifstream fin("C:\\Users\\aschi\\Dropbox\\AERO 552\\Final Project\\tests\\test_grammar.txt");
+    std::istringstream fin(test_grammar);
     parser_generator p(fin);
+    symbols = &p.get_symbols();
     auto item_sets = p.create_item_sets();
-    p.create_translation_table(item_sets);
     p.create_extended_grammar(item_sets);
     for(const auto& rule: p._M_extended_grammar)
     {
@@ -130,52 +172,55 @@ BEGIN_TEST(Extended_Grammar, Test extended grammar)
 END_TEST()
 
 BEGIN_TEST(First_Set, Test making first set)
-    std::ifstream fin("C:\\Users\\aschi\\Dropbox\\AERO 552\\Final Project\\tests\\test_grammar.txt");
+    std::istringstream fin(test_grammar);
     parser_generator p(fin);
+    symbols = &p.get_symbols();
     auto item_sets = p.create_item_sets();
-    p.create_translation_table(item_sets);
     p.create_extended_grammar(item_sets);
+    p.compute_nullables();
     p.create_first_sets();
-    auto sets = p._M_first_sets;
-    for(const auto& pair: sets)
+    const auto& sets = p._M_first_sets;
+    for(size_t i = 0; i < sets.size(); ++i)
     {
-        auto s = pair.first;
-        std::cout << "{" << s.second.first << "_" << s.first << "_" << s.second.second << ", {";
-        for(const auto& str: pair.second)
-        {
-            std::cout << str << " ";
-        }
+        auto s = p._M_extended_symbols[i];
+        std::cout << "{" << s.second.first << "_" << symbols->name(s.first) << "_" << s.second.second << ", {";
+        sets[i].for_each([](size_t symbol)
+            {
+                std::cout << symbols->name(symbol) << " ";
+            });
         std::cout << "}}\n";
     }
 END_TEST()
 
 BEGIN_TEST(Follow_Set, Test making follow set)
-    std::ifstream fin("C:\\Users\\aschi\\Dropbox\\AERO 552\\Final Project\\tests\\test_grammar.txt");
+    std::istringstream fin(test_grammar);
     parser_generator p(fin);
+    symbols = &p.get_symbols();
     auto item_sets = p.create_item_sets();
-    p.create_translation_table(item_sets);
     p.create_extended_grammar(item_sets);
+    p.compute_nullables();
     p.create_first_sets();
     p.create_follow_sets();
-    auto sets = p._M_follow_sets;
-    for(const auto& pair: sets)
+    const auto& sets = p._M_follow_sets;
+    for(size_t i = 0; i < sets.size(); ++i)
     {
-        auto s = pair.first;
-        std::cout << "{" << s.second.first << "_" << s.first << "_" << s.second.second << ", {";
-        for(const auto& str: pair.second)
-        {
-            std::cout << str << " ";
-        }
+        auto s = p._M_extended_symbols[i];
+        std::cout << "{" << s.second.first << "_" << symbols->name(s.first) << "_" << s.second.second << ", {";
+        sets[i].for_each([](size_t symbol)
+            {
+                std::cout << symbols->name(symbol) << " ";
+            });
         std::cout << "}}\n";
     }
 END_TEST()
 
 BEGIN_TEST(GOTO_Table, Test making GOTO table)
-    std::ifstream fin("C:\\Users\\aschi\\Dropbox\\AERO 552\\Final Project\\tests\\test_grammar.txt");
+    std::istringstream fin(test_grammar);
     parser_generator p(fin);
+    symbols = &p.get_symbols();
     auto item_sets = p.create_item_sets();
-    p.create_translation_table(item_sets);
     p.create_extended_grammar(item_sets);
+    p.compute_nullables();
     p.create_first_sets();
     p.create_follow_sets();
     auto table = p.create_goto_table();
@@ -183,17 +228,184 @@ BEGIN_TEST(GOTO_Table, Test making GOTO table)
 END_TEST()
 
 BEGIN_TEST(Action_Table, Test making action table)
-    std::ifstream fin("C:\\Users\\aschi\\Dropbox\\AERO 552\\Final Project\\tests\\test_grammar.txt");
+    std::istringstream fin(test_grammar);
     parser_generator p(fin);
+    symbols = &p.get_symbols();
     auto item_sets = p.create_item_sets();
-    p.create_translation_table(item_sets);
     p.create_extended_grammar(item_sets);
+    p.compute_nullables();
     p.create_first_sets();
     p.create_follow_sets();
+    p.create_extended_lookaheads(item_sets);
     auto table = p.create_action_table(item_sets);
     print_action_table(table);
 END_TEST()
 
+BEGIN_TEST(Lookaheads, DeRemer and Pennello lookaheads match the extended grammar)
+    std::istringstream fin(test_grammar);
+    std::istringstream fin2(test_grammar);
+    parser_generator p(fin);
+    parser_generator extended(fin2, parser_generator::LA_EXTENDED_GRAMMAR);
+    auto tables = p.create_parse_tables();
+    auto extended_tables = extended.create_parse_tables();
+    print_action_table(tables.first);
+    passed = tables.first.get_table() == extended_tables.first.get_table() ? 1 : -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Recursive_Start, Lookaheads of a grammar whose start symbol is on a right hand side)
+    //The transition on S follows the S rules up to their $
+    const char* grammar = "terminals: a b\n"
+        "S -> a S\n"
+        "S -> b\n";
+    std::istringstream in(grammar), extended_in(grammar);
+    parser_generator p(in);
+    parser_generator extended(extended_in, parser_generator::LA_EXTENDED_GRAMMAR);
+    auto tables = p.create_parse_tables();
+    auto extended_tables = extended.create_parse_tables();
+    passed = tables.first.get_table() == extended_tables.first.get_table() ? 1 : -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Nullable_Follow, Follow sets pass through nullable symbols at every occurrence)
+    //Y is followed by c or b in the first rule, and by a or $ in the second,
+    //where each Y and Z can be empty
+    const char* grammar = "terminals: a b c d\n"
+        "S -> X\n"
+        "X -> a Y Z b\n"
+        "X -> b Z Y a Y\n"
+        "Y -> d\n"
+        "Y ->\n"
+        "Z -> c\n"
+        "Z ->\n";
+    std::istringstream in(grammar), extended_in(grammar);
+    parser_generator p(in);
+    parser_generator extended(extended_in, parser_generator::LA_EXTENDED_GRAMMAR);
+    auto tables = p.create_parse_tables();
+    auto extended_tables = extended.create_parse_tables();
+    passed = tables.first.get_table() == extended_tables.first.get_table() ? 1 : -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(LR1_States, Pager merging splits the state LALR(1) merges into a reduce/reduce conflict)
+    //LR(1) but not LALR(1): the states after "a e" and "b e" have the same items
+    const char* grammar = "terminals: a b c d e\n"
+        "S -> X\n"
+        "X -> a E c\n"
+        "X -> a F d\n"
+        "X -> b F c\n"
+        "X -> b E d\n"
+        "E -> e\n"
+        "F -> e\n";
+    std::istringstream lalr_in(grammar), pager_in(grammar), canonical_in(grammar);
+    parser_generator lalr(lalr_in);
+    parser_generator pager(pager_in, parser_generator::LA_PAGER_LR1);
+    parser_generator canonical(canonical_in, parser_generator::LA_CANONICAL_LR1);
+    auto lalr_tables = lalr.create_parse_tables();
+    auto pager_tables = pager.create_parse_tables();
+    auto canonical_tables = canonical.create_parse_tables();
+    symbols = &pager.get_symbols();
+    print_action_table(pager_tables.first);
+    passed = pager_tables.first.get_table().size() == lalr_tables.first.get_table().size() + 1 
+        && pager_tables.first.get_table() == canonical_tables.first.get_table() ? 1 : -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Canonical_Lookaheads, Canonical LR(1) states merged by kernel have the LALR(1) lookaheads)
+    //The state after B reduces C -> on b, which only reaches it from D -> C b a 
+    //through the start items of C and D
+    const char* grammar = "terminals: a b\n"
+        "S -> B\n"
+        "S -> a\n"
+        "A -> B\n"
+        "B -> B C A\n"
+        "C -> D\n"
+        "C -> A a\n"
+        "C ->\n"
+        "D -> C b a\n";
+    std::istringstream lalr_in(grammar), canonical_in(grammar);
+    parser_generator lalr(lalr_in);
+    parser_generator canonical(canonical_in, parser_generator::LA_CANONICAL_LR1);
+    auto lalr_sets = lalr.create_item_sets();
+    lalr.create_lookaheads(lalr_sets);
+    auto canonical_sets = canonical.create_lr1_item_sets(false);
+    //States with the same kernel have the same items
+    std::map<std::vector<parser_generator::item_t>, size_t> lalr_states;
+    for(size_t i = 0; i < lalr_sets.size(); ++i)
+        lalr_states[lalr_sets[i]._M_items] = i;
+    //The lookaheads of each reduction of an LALR(1) state are the union of the 
+    //lookaheads of the canonical states with its kernel
+    std::vector<std::map<size_t, dynamic_bitset>> merged(lalr_sets.size());
+    bool same = true;
+    for(size_t i = 0; i < canonical_sets.size(); ++i)
+    {
+        auto state = lalr_states.find(canonical_sets[i]._M_items);
+        if (state == lalr_states.end())
+        {
+            same = false;
+            continue;
+        }
+        for(const auto& reduction: canonical._M_reductions[i])
+        {
+            auto& lookaheads = merged[state->second][reduction._M_production];
+            if (lookaheads.size() == 0)
+                lookaheads = reduction._M_lookaheads;
+            else
+                lookaheads.merge(reduction._M_lookaheads);
+        }
+    }
+    for(size_t i = 0; i < lalr_sets.size(); ++i)
+    {
+        same = same && merged[i].size() == lalr._M_reductions[i].size();
+        for(const auto& reduction: lalr._M_reductions[i])
+        {
+            auto it = merged[i].find(reduction._M_production);
+            same = same && it != merged[i].end() && it->second == reduction._M_lookaheads;
+        }
+    }
+    passed = same ? 1 : -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Compressed_Tables, Compressed tables keep every action and goto)
+    std::istringstream fin(test_grammar2);
+    parser_generator p(fin);
+    auto tables = p.create_parse_tables();
+    auto compressed = parser_generator::compress_tables(tables.first, tables.second);
+    bool same = true;
+    const auto& actions = tables.first.get_table();
+    const auto& gotos = tables.second.get_table();
+    for(size_t state = 0; state < actions.size(); ++state)
+    {
+        for(size_t column = 0; column < compressed._M_action_columns.size(); ++column)
+        {
+            auto it = actions[state].find(compressed._M_action_columns[column]);
+            auto action = compressed.action(state, column);
+            //A missing action is an error or the state's default reduction
+            if (it != actions[state].end())
+                same = same && action == parser_generator::pack_action(it->second);
+            else if (action != parser_generator::PA_ERROR)
+            {
+                same = same && parser_generator::action_kind(action) == parser_generator::PA_REDUCE &&
+                    std::any_of(actions[state].begin(), actions[state].end(),
+                        [&](const std::pair<const std::string, final_project::automata::state_t>& a)
+                        {
+                            return parser_generator::pack_action(a.second) == action;
+                        });
+            }
+        }
+        for(size_t column = 0; column < compressed._M_goto_columns.size(); ++column)
+        {
+            auto it = gotos[state].find(compressed._M_goto_columns[column]);
+            if (it != gotos[state].end())
+                same = same && compressed.goto_state(state, column) == it->second;
+        }
+    }
+    parser_generator::print_compressed_tables(std::cout, compressed);
+    passed = same ? 1 : -1;
+    PASS_OR_FAIL()
+END_TEST()
+
 TEST_MAIN()
 
 #endif
\ No newline at end of file
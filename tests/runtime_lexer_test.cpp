@@ -0,0 +1,98 @@
+#include "unit_test_framework.hh"
+
+#include "lexer/runtime_lexer.hh"
+#include "exception/exceptions.hh"
+
+#include <sstream>
+
+using namespace final_project::lexer;
+
+#define CREATE_LEXER(exp)\
+    std::string regex = exp;\
+    std::istringstream str_in(regex);\
+    runtime_lexer l(str_in);
+
+//Returns the type, offset, and length of every token as one vector
+std::vector<size_t> flatten(const std::vector<runtime_lexer::token_t>& tokens)
+{
+    std::vector<size_t> flat;
+    for(const auto& tok: tokens)
+    {
+        flat.push_back(tok._M_type);
+        flat.push_back(tok._M_offset);
+        flat.push_back(tok._M_length);
+    }
+    return flat;
+}
+
+//Returns true if a lexer cannot be built from the specification
+bool rejected(const std::string& spec)
+{
+    std::istringstream in(spec);
+    try
+    {
+        runtime_lexer l(in);
+    }
+    catch(const final_project::exceptions::invalid_regex_exception&)
+    {
+        return true;
+    }
+    return false;
+}
+
+TESTING_SETUP()
+
+BEGIN_TEST(Runtime_Lexer_Names, Token types are numbered like the generated enum)
+    passed = 1;
+    CREATE_LEXER("plus: +\nint: (0|1|2|3|4|5|6|7|8|9)(0|1|2|3|4|5|6|7|8|9)*")
+    CONTENT_CHECK(std::vector<std::string>({"int", "plus", "EOF", "ERROR"}), l.token_names())
+    if (l.eof_type() != 2 || l.error_type() != 3)
+        passed = -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Runtime_Lexer_Tokens, Lex a string with the compiled DFA)
+    passed = 1;
+    CREATE_LEXER("plus: +\nint: (0|1|2|3|4|5|6|7|8|9)(0|1|2|3|4|5|6|7|8|9)*")
+    auto tokens = l.tokenize("12 + 3+45\n");
+    CONTENT_CHECK(std::vector<size_t>({0, 0, 2,  1, 3, 1,  0, 5, 1,  1, 6, 1,  0, 7, 2,  2, 10, 0}), flatten(tokens))
+    //Each digit and '+' have a class of their own; every other character shares one
+    if (l.num_classes() != 12)
+        passed = -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Runtime_Lexer_Errors, Characters that start no token become error tokens)
+    passed = 1;
+    CREATE_LEXER("ab: ab")
+    //"a" followed by whitespace or an unknown character is an error that includes that character
+    auto tokens = l.tokenize("ab # a b");
+    CONTENT_CHECK(std::vector<size_t>({0, 0, 2,  2, 3, 1,  2, 5, 2,  2, 7, 1,  1, 8, 0}), flatten(tokens))
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Runtime_Lexer_JIT, Native code produces the same tokens as the table interpreter)
+    passed = 1;
+    std::string spec = "ident: (a|b|c|x|y|z)(a|b|c|x|y|z|0|1|2)*\nint: (0|1|2)(0|1|2)*\nplus: +";
+    std::istringstream interpreted_in(spec);
+    std::istringstream jit_in(spec);
+    runtime_lexer interpreted(interpreted_in);
+    runtime_lexer jit(jit_in, true);
+    std::cout << "Using native code: " << jit.is_jit() << std::endl;
+    std::string text = "abc+12 x0y1 + 3 22+z\n\t#c2 2a ";
+    text += '\xff';
+    text += "b";
+    CONTENT_CHECK(flatten(interpreted.tokenize(text)), flatten(jit.tokenize(text)))
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Runtime_Lexer_Keywords, Keyword declarations have to name token types)
+    passed = 1;
+    const std::string rules = "ident: (a|b|-)(a|b|-)*\n";
+    if (rejected(rules + "keywords ident: ab ba") || !rejected(rules + "keywords ident:") || 
+            !rejected(rules + "keywords ident: ab a-b"))
+        passed = -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+TEST_MAIN()
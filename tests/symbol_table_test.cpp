@@ -0,0 +1,34 @@
+#include "unit_test_framework.hh"
+
+#include "parser/symbol_table.hh"
+
+using namespace final_project::parser;
+
+TESTING_SETUP()
+
+BEGIN_TEST(Symbol_Table_Order, Ids follow the sorted order of the names)
+    passed = 1;
+    std::vector<std::string> names = {"expr", "+", "S", "$", "num", "+"};
+    symbol_table symbols(names.begin(), names.end());
+    if (symbols.size() != 5)
+        passed = -1;
+    std::vector<std::string> sorted;
+    for(symbol_t symbol = 0; symbol < symbols.size(); ++symbol)
+        sorted.push_back(symbols.name(symbol));
+    CONTENT_CHECK(std::vector<std::string>({"$", "+", "S", "expr", "num"}), sorted)
+    PASS_OR_FAIL()
+END_TEST()
+
+BEGIN_TEST(Symbol_Table_Intern, Interning a name twice returns the same id)
+    passed = 1;
+    symbol_table symbols;
+    symbol_t a = symbols.intern("a");
+    symbol_t b = symbols.intern("b");
+    if (a == b || symbols.intern("a") != a || symbols.find("b") != b)
+        passed = -1;
+    if (symbols.find("c") != NO_SYMBOL || symbols.name(b) != "b")
+        passed = -1;
+    PASS_OR_FAIL()
+END_TEST()
+
+TEST_MAIN()